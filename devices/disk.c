@@ -1,15 +1,58 @@
 #include "devices/disk.h"
 #include <ctype.h>
 #include <debug.h>
+#include <round.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 /* The code in this file is an interface to an ATA (IDE)
-   controller.  It attempts to comply to [ATA-3]. */
+   controller.  It attempts to comply to [ATA-3].
+
+   Transfers of any number of sectors are issued as single
+   commands of up to MAX_XFER_SECTORS sectors.  If the PCI bus
+   finds an IDE controller capable of bus mastering (QEMU's PIIX
+   is), data moves by DMA, described to the controller by a table
+   of physical region descriptors; otherwise the sectors are
+   copied through the data register in PIO mode.
+
+   Requests are not issued by the threads that make them.  Each
+   channel has a queue of pending requests and an I/O thread that
+   is the only one to touch the controller once the disks are
+   identified.  disk_submit queues a request and returns at once;
+   the I/O thread calls the request's completion function when
+   the transfer is done.  The synchronous functions submit a
+   request and wait for it.
+
+   The I/O thread picks requests in C-SCAN order: the request at
+   the lowest position at or after the end of the previous
+   transfer, wrapping around to the lowest position overall.
+   Each request also has a deadline, shorter for reads than for
+   writes, and an expired request goes first, so a stream of
+   nearby requests cannot starve a distant one.  Queued requests
+   that continue the chosen one on the same disk in the same
+   direction are merged into a single command.
+
+   A virtual disk has no channel of its own.  It maps its sectors
+   onto member disks: a stripe spreads fixed-size units across
+   its members in turn, and a slice is a contiguous range of one
+   member.  disk_submit splits a request to a virtual disk into
+   pieces that each lie on a single ATA disk and queues them all
+   at once, so pieces on different channels are transferred in
+   parallel.  Pieces of consecutive units on the same member are
+   adjacent there and merge back into one command.
+
+   A RAM disk keeps its sectors in kernel pages, allocated when a
+   page is first written; pages never written read as zeros.  Its
+   requests are served at once by the thread that submits them. */
 
 /* ATA command block port addresses. */
 #define reg_data(CHANNEL) ((CHANNEL)->reg_base + 0)     /* Data. */
@@ -47,11 +90,76 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_DMA 0xc8               /* READ DMA. */
+#define CMD_WRITE_DMA 0xca              /* WRITE DMA. */
+
+/* Status Register bits, continued. */
+#define STA_ERR 0x01            /* Error. */
+
+/* Bus master IDE registers, relative to a channel's bm_base. */
+#define BM_COMMAND 0            /* Command. */
+#define BM_STATUS 2             /* Status. */
+#define BM_PRDT 4               /* Physical address of PRD table. */
+
+/* Bus master Command Register bits. */
+#define BMC_START 0x01          /* Start transfer. */
+#define BMC_READ 0x08           /* Direction: 1=device to memory. */
+
+/* Bus master Status Register bits. */
+#define BMS_ERROR 0x02          /* Error, write 1 to clear. */
+#define BMS_INTR 0x04           /* Interrupt, write 1 to clear. */
+
+/* Most sectors moved by a single command.  A sector count of 0
+   in the Sector Count register means 256. */
+#define MAX_XFER_SECTORS 256
+
+/* Physical region descriptor: one physically contiguous piece of
+   a DMA buffer.  A piece may not cross a 64 kB boundary. */
+struct prd {
+	uint32_t addr;              /* Physical address. */
+	uint16_t size;              /* Size in bytes, 0 means 64 kB. */
+	uint16_t flags;             /* PRD_EOT on the last entry. */
+};
+#define PRD_EOT 0x8000
+
+/* Most requests merged into a single command. */
+#define MAX_MERGE_REQUESTS 16
+
+/* Ticks a read or write request may wait in the queue before it
+   is served ahead of the elevator order. */
+#define READ_EXPIRE (TIMER_FREQ / 10)
+#define WRITE_EXPIRE (TIMER_FREQ / 2)
+
+/* PRD entries per channel.  MAX_XFER_SECTORS sectors span at most
+   this many 64 kB regions, and each merged request's buffer may
+   add one more. */
+#define PRD_CNT (MAX_XFER_SECTORS * DISK_SECTOR_SIZE / 0x10000 \
+		+ MAX_MERGE_REQUESTS)
+
+/* Requests available for the pieces of requests to virtual
+   disks.  A submitter waits when they are all in flight. */
+#define PIECE_CNT 64
 
-/* An ATA device. */
+/* Sectors in each page of a RAM disk. */
+#define RAM_PAGE_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Most members of a stripe. */
+#define STRIPE_MAX_MEMBERS 4
+
+/* An ATA device or a virtual disk. */
 struct disk {
 	char name[8];               /* Name, e.g. "hd0:1". */
-	struct channel *channel;    /* Channel disk is on. */
+	struct channel *channel;    /* Channel disk is on, NULL if virtual. */
+
+	/* Virtual disks only. */
+	struct disk *members[STRIPE_MAX_MEMBERS];   /* Member disks. */
+	size_t member_cnt;          /* Number of members. */
+	disk_sector_t unit;         /* Sectors per member in turn. */
+	disk_sector_t start;        /* First sector used on each member. */
+
+	/* RAM disks only. */
+	uint8_t **ram_pages;        /* Kernel page of each page of sectors. */
+	struct lock ram_lock;       /* Protects RAM_PAGES. */
 	int dev_no;                 /* Device 0 or 1 for master or slave. */
 
 	bool is_ata;                /* 1=This device is an ATA disk. */
@@ -68,11 +176,19 @@ struct channel {
 	uint16_t reg_base;          /* Base I/O port. */
 	uint8_t irq;                /* Interrupt in use. */
 
-	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
 
+	struct lock lock;           /* Protects queue. */
+	struct list queue;          /* Pending requests, oldest first. */
+	struct condition queue_not_empty;   /* Signaled on submission. */
+	uint64_t head;              /* Position just past the last transfer. */
+
+	uint16_t bm_base;           /* Bus master base port, 0 if no DMA. */
+	struct prd prdt[PRD_CNT]    /* PRD table; aligned so it does not */
+		__attribute__ ((aligned (256)));  /* cross a 64 kB boundary. */
+
 	struct disk devices[2];     /* The devices on this channel. */
 };
 
@@ -80,12 +196,30 @@ struct channel {
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
 
+/* Requests for the pieces of virtual disk requests. */
+static struct disk_request pieces[PIECE_CNT];
+static struct list free_pieces;     /* Protected by disabling interrupts. */
+static struct semaphore pieces_avail;
+
 static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
-static void issue_pio_command (struct channel *, uint8_t command);
+static void find_bus_master (void);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
+static void issue_command (struct channel *, uint8_t command);
+static void io_thread (void *channel_);
+static void dispatch (struct channel *, struct list *batch);
+static bool dma_transfer (struct disk *, disk_sector_t, size_t cnt,
+		struct list *batch, bool write);
+static bool pio_transfer (struct disk *, disk_sector_t, size_t cnt,
+		struct list *batch, bool write);
+static void transfer_sync (struct disk *, disk_sector_t, size_t cnt,
+		void *buffer, bool write);
+static struct disk *virtual_disk (struct disk *members[], size_t cnt,
+		disk_sector_t unit, disk_sector_t start, disk_sector_t capacity);
+static void submit_pieces (struct disk_request *);
+static void ram_transfer (struct disk_request *);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
 
@@ -100,6 +234,12 @@ static void interrupt_handler (struct intr_frame *);
 void
 disk_init (void) {
 	size_t chan_no;
+	size_t i;
+
+	list_init (&free_pieces);
+	for (i = 0; i < PIECE_CNT; i++)
+		list_push_back (&free_pieces, &pieces[i].elem);
+	sema_init (&pieces_avail, PIECE_CNT);
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
 		struct channel *c = &channels[chan_no];
@@ -119,9 +259,13 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		lock_init (&c->lock);
+		list_init (&c->queue);
+		cond_init (&c->queue_not_empty);
+		c->head = 0;
+		c->bm_base = 0;
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -129,6 +273,7 @@ disk_init (void) {
 			snprintf (d->name, sizeof d->name, "%s:%d", c->name, dev_no);
 			d->channel = c;
 			d->dev_no = dev_no;
+			d->member_cnt = 0;
 
 			d->is_ata = false;
 			d->capacity = 0;
@@ -152,6 +297,20 @@ disk_init (void) {
 				identify_ata_device (&c->devices[dev_no]);
 	}
 
+	find_bus_master ();
+
+	/* From here on, only the I/O threads touch the controllers. */
+	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+		struct channel *c = &channels[chan_no];
+		char name[16];
+
+		if (!c->devices[0].is_ata && !c->devices[1].is_ata)
+			continue;
+		snprintf (name, sizeof name, "%s-io", c->name);
+		if (thread_create (name, PRI_DEFAULT, io_thread, c) == TID_ERROR)
+			PANIC ("%s: cannot create I/O thread", c->name);
+	}
+
 	/* DO NOT MODIFY BELOW LINES. */
 	register_disk_inspect_intr ();
 }
@@ -203,27 +362,90 @@ disk_size (struct disk *d) {
 	return d->capacity;
 }
 
+/* Returns a new virtual disk that stripes the CNT disks in
+   MEMBERS[]: sectors go to the members UNIT at a time, in turn.
+   Each member contributes as many whole units as the smallest
+   one holds.  Returns a null pointer if memory is short. */
+struct disk *
+disk_stripe (struct disk *members[], size_t cnt, disk_sector_t unit) {
+	disk_sector_t units = UINT32_MAX;
+	size_t i;
+
+	ASSERT (cnt > 0 && cnt <= STRIPE_MAX_MEMBERS);
+	ASSERT (unit > 0);
+
+	for (i = 0; i < cnt; i++) {
+		ASSERT (members[i] != NULL);
+		if (disk_size (members[i]) / unit < units)
+			units = disk_size (members[i]) / unit;
+	}
+	return virtual_disk (members, cnt, unit, 0, units * unit * cnt);
+}
+
+/* Returns a new virtual disk made of the SIZE sectors of disk D
+   that start at sector START.  Returns a null pointer if memory
+   is short. */
+struct disk *
+disk_slice (struct disk *d, disk_sector_t start, disk_sector_t size) {
+	ASSERT (d != NULL);
+	ASSERT (size > 0 && start <= disk_size (d)
+			&& size <= disk_size (d) - start);
+
+	return virtual_disk (&d, 1, size, start, size);
+}
+
+/* Returns a new RAM disk of CAPACITY sectors, initially all
+   zeros.  Returns a null pointer if memory is short. */
+struct disk *
+disk_ram (disk_sector_t capacity) {
+	struct disk *d;
+
+	ASSERT (capacity > 0);
+
+	d = calloc (1, sizeof *d);
+	if (d == NULL)
+		return NULL;
+	d->ram_pages = calloc (DIV_ROUND_UP (capacity, RAM_PAGE_SECTORS),
+			sizeof *d->ram_pages);
+	if (d->ram_pages == NULL) {
+		free (d);
+		return NULL;
+	}
+	snprintf (d->name, sizeof d->name, "ram");
+	lock_init (&d->ram_lock);
+	d->capacity = capacity;
+	return d;
+}
+
+/* Creates a virtual disk of CAPACITY sectors over the CNT disks
+   in MEMBERS[], UNIT sectors per member in turn, starting at
+   sector START of each member. */
+static struct disk *
+virtual_disk (struct disk *members[], size_t cnt, disk_sector_t unit,
+		disk_sector_t start, disk_sector_t capacity) {
+	struct disk *d = calloc (1, sizeof *d);
+	size_t i;
+
+	if (d == NULL)
+		return NULL;
+	snprintf (d->name, sizeof d->name, "%s", cnt > 1 ? "stripe" : "slice");
+	for (i = 0; i < cnt; i++)
+		d->members[i] = members[i];
+	d->member_cnt = cnt;
+	d->unit = unit;
+	d->start = start;
+	d->is_ata = false;
+	d->capacity = capacity;
+	return d;
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for DISK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
-
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_read_multiple (d, sec_no, 1, buffer);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -233,23 +455,503 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, 1, buffer);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes and must be a kernel address.  Each MAX_XFER_SECTORS
+   sectors take a single command.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer) {
+	transfer_sync (d, sec_no, cnt, buffer, false);
+}
+
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes
+   and must be a kernel address.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		const void *buffer) {
+	transfer_sync (d, sec_no, cnt, (void *) buffer, true);
+}
+
+/* Initializes R as a request to move CNT sectors starting at
+   SEC_NO between disk D and BUFFER, writing to the disk if WRITE
+   is true and reading from it otherwise.  CNT must be between 1
+   and MAX_XFER_SECTORS and BUFFER must be a kernel address.  DONE
+   will be called with AUX once the transfer is complete. */
+void
+disk_request_init (struct disk_request *r, struct disk *d,
+		disk_sector_t sec_no, size_t cnt, void *buffer, bool write,
+		disk_done_func *done, void *aux) {
+	r->disk = d;
+	r->sector = sec_no;
+	r->cnt = cnt;
+	r->buffer = buffer;
+	r->write = write;
+	r->deadline = 0;
+	r->done = done;
+	r->aux = aux;
+}
+
+/* Queues request R, initialized with disk_request_init, and
+   returns without waiting for it.  R must stay in place until
+   its completion function has been called. */
+void
+disk_submit (struct disk_request *r) {
 	struct channel *c;
 
+	ASSERT (r != NULL && r->disk != NULL);
+	ASSERT (r->buffer != NULL && r->done != NULL);
+	ASSERT (r->cnt > 0 && r->cnt <= MAX_XFER_SECTORS);
+	ASSERT (r->sector < r->disk->capacity
+			&& r->cnt <= r->disk->capacity - r->sector);
+
+	if (r->disk->ram_pages != NULL) {
+		ram_transfer (r);
+		return;
+	}
+	if (r->disk->channel == NULL) {
+		submit_pieces (r);
+		return;
+	}
+
+	c = r->disk->channel;
+	r->deadline = timer_ticks () + (r->write ? WRITE_EXPIRE : READ_EXPIRE);
+	lock_acquire (&c->lock);
+	list_push_back (&c->queue, &r->elem);
+	cond_signal (&c->queue_not_empty, &c->lock);
+	lock_release (&c->lock);
+}
+
+/* Serves request R to a RAM disk in the calling thread and
+   completes it. */
+static void
+ram_transfer (struct disk_request *r) {
+	struct disk *d = r->disk;
+	uint8_t *buffer = r->buffer;
+	disk_sector_t sec_no = r->sector;
+	size_t cnt = r->cnt;
+
+	lock_acquire (&d->ram_lock);
+	while (cnt > 0) {
+		size_t page_no = sec_no / RAM_PAGE_SECTORS;
+		size_t ofs = sec_no % RAM_PAGE_SECTORS;
+		size_t n = RAM_PAGE_SECTORS - ofs < cnt ? RAM_PAGE_SECTORS - ofs : cnt;
+		uint8_t *page = d->ram_pages[page_no];
+
+		if (r->write) {
+			if (page == NULL) {
+				page = d->ram_pages[page_no] = palloc_get_page (PAL_ZERO);
+				if (page == NULL)
+					PANIC ("%s: out of memory, sector=%"PRDSNu, d->name, sec_no);
+			}
+			memcpy (page + ofs * DISK_SECTOR_SIZE, buffer, n * DISK_SECTOR_SIZE);
+		} else if (page != NULL)
+			memcpy (buffer, page + ofs * DISK_SECTOR_SIZE, n * DISK_SECTOR_SIZE);
+		else
+			memset (buffer, 0, n * DISK_SECTOR_SIZE);
+		sec_no += n;
+		buffer += n * DISK_SECTOR_SIZE;
+		cnt -= n;
+	}
+	if (r->write)
+		d->write_cnt += r->cnt;
+	else
+		d->read_cnt += r->cnt;
+	lock_release (&d->ram_lock);
+
+	r->done (r->aux);
+}
+
+/* Finds where sector *SEC_NO of virtual disk *D lies, going
+   down through nested virtual disks to an ATA disk, and stores
+   that disk and sector back.  Returns the number of sectors from
+   there on that stay contiguous on that disk. */
+static disk_sector_t
+map_sector (struct disk **d, disk_sector_t *sec_no) {
+	disk_sector_t run = UINT32_MAX;
+
+	while ((*d)->member_cnt > 0) {
+		struct disk *v = *d;
+		disk_sector_t unit_no = *sec_no / v->unit;
+		disk_sector_t ofs = *sec_no % v->unit;
+
+		if (v->unit - ofs < run)
+			run = v->unit - ofs;
+		*d = v->members[unit_no % v->member_cnt];
+		*sec_no = v->start + unit_no / v->member_cnt * v->unit + ofs;
+	}
+	return run;
+}
+
+/* Completion function of a piece of a virtual disk request.
+   Returns the piece to the pool and completes the request it
+   belongs to once that has no pieces left. */
+static void
+piece_done (void *piece_) {
+	struct disk_request *piece = piece_;
+	struct disk_request *r = piece->aux;
+	enum intr_level old_level;
+	bool last;
+
+	old_level = intr_disable ();
+	last = --r->pending == 0;
+	list_push_back (&free_pieces, &piece->elem);
+	intr_set_level (old_level);
+	sema_up (&pieces_avail);
+
+	if (last)
+		r->done (r->aux);
+}
+
+/* Splits request R to a virtual disk into pieces that each lie
+   on one ATA disk and queues them.  R is completed when its last
+   piece is. */
+static void
+submit_pieces (struct disk_request *r) {
+	uint8_t *buffer = r->buffer;
+	disk_sector_t sec_no = r->sector;
+	size_t cnt = r->cnt;
+	enum intr_level old_level;
+	bool last;
+
+	/* One extra count keeps R from completing before every piece
+	   has been queued. */
+	r->pending = 1;
+	while (cnt > 0) {
+		struct disk *d = r->disk;
+		disk_sector_t member_sec = sec_no;
+		disk_sector_t run = map_sector (&d, &member_sec);
+		size_t n = cnt < run ? cnt : run;
+		struct disk_request *piece;
+
+		sema_down (&pieces_avail);
+		old_level = intr_disable ();
+		piece = list_entry (list_pop_front (&free_pieces),
+				struct disk_request, elem);
+		r->pending++;
+		intr_set_level (old_level);
+
+		disk_request_init (piece, d, member_sec, n, buffer, r->write,
+				piece_done, r);
+		disk_submit (piece);
+		sec_no += n;
+		buffer += n * DISK_SECTOR_SIZE;
+		cnt -= n;
+	}
+
+	old_level = intr_disable ();
+	last = --r->pending == 0;
+	intr_set_level (old_level);
+	if (last)
+		r->done (r->aux);
+}
+
+/* Completion function that ups the semaphore SEMA_. */
+static void
+wake_up (void *sema_) {
+	sema_up (sema_);
+}
+
+/* Moves CNT sectors starting at SEC_NO between disk D and BUFFER
+   through the request queue, and waits for the transfer. */
+static void
+transfer_sync (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer_, bool write) {
+	uint8_t *buffer = buffer_;
+	struct disk_request r;
+	struct semaphore done;
+
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
+	sema_init (&done, 0);
+	while (cnt > 0) {
+		size_t n = cnt < MAX_XFER_SECTORS ? cnt : MAX_XFER_SECTORS;
+
+		disk_request_init (&r, d, sec_no, n, buffer, write, wake_up, &done);
+		disk_submit (&r);
+		sema_down (&done);
+		sec_no += n;
+		buffer += n * DISK_SECTOR_SIZE;
+		cnt -= n;
+	}
+}
+
+/* Position of sector SEC_NO of disk D in the elevator order of
+   its channel.  Device 0 comes before device 1. */
+static uint64_t
+position (const struct disk *d, disk_sector_t sec_no) {
+	return (uint64_t) d->dev_no << 32 | sec_no;
+}
+
+/* I/O thread of the channel CHANNEL_.  Serves the queue forever,
+   one merged batch of requests at a time. */
+static void
+io_thread (void *channel_) {
+	struct channel *c = channel_;
+
+	for (;;) {
+		struct list batch;
+		struct disk_request *first;
+		size_t cnt = 0;
+		bool ok;
+
+		lock_acquire (&c->lock);
+		while (list_empty (&c->queue))
+			cond_wait (&c->queue_not_empty, &c->lock);
+		dispatch (c, &batch);
+		lock_release (&c->lock);
+
+		first = list_entry (list_front (&batch), struct disk_request, elem);
+		for (struct list_elem *e = list_begin (&batch); e != list_end (&batch);
+				e = list_next (e))
+			cnt += list_entry (e, struct disk_request, elem)->cnt;
+
+		if (c->bm_base != 0)
+			ok = dma_transfer (first->disk, first->sector, cnt, &batch,
+					first->write);
+		else
+			ok = pio_transfer (first->disk, first->sector, cnt, &batch,
+					first->write);
+		if (!ok)
+			PANIC ("%s: disk %s failed, sector=%"PRDSNu, first->disk->name,
+					first->write ? "write" : "read", first->sector);
+		if (first->write)
+			first->disk->write_cnt += cnt;
+		else
+			first->disk->read_cnt += cnt;
+
+		/* A request may be gone once its completion function
+		   returns, so take it off the list first. */
+		while (!list_empty (&batch)) {
+			struct disk_request *r = list_entry (list_pop_front (&batch),
+					struct disk_request, elem);
+			r->done (r->aux);
+		}
+	}
+}
+
+/* Moves the next requests to serve from C's queue, which must
+   not be empty, to BATCH, in sector order.  The caller must hold
+   C's lock. */
+static void
+dispatch (struct channel *c, struct list *batch) {
+	struct disk_request *pick = NULL, *lowest = NULL, *expired = NULL;
+	int64_t now = timer_ticks ();
+	disk_sector_t start, end;
+	size_t merged = 1;
+	struct list_elem *e;
+
+	ASSERT (!list_empty (&c->queue));
+
+	/* An expired request goes first; otherwise the next one in
+	   C-SCAN order. */
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		uint64_t pos = position (r->disk, r->sector);
+
+		if (r->deadline <= now
+				&& (expired == NULL || r->deadline < expired->deadline))
+			expired = r;
+		if (pos >= c->head
+				&& (pick == NULL || pos < position (pick->disk, pick->sector)))
+			pick = r;
+		if (lowest == NULL || pos < position (lowest->disk, lowest->sector))
+			lowest = r;
+	}
+	if (expired != NULL)
+		pick = expired;
+	else if (pick == NULL)
+		pick = lowest;
+
+	list_init (batch);
+	list_remove (&pick->elem);
+	list_push_back (batch, &pick->elem);
+	start = pick->sector;
+	end = pick->sector + pick->cnt;
+
+	/* Merge requests that extend the batch at either end. */
+	e = list_begin (&c->queue);
+	while (e != list_end (&c->queue) && merged < MAX_MERGE_REQUESTS) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+
+		if (r->disk != pick->disk || r->write != pick->write
+				|| end - start + r->cnt > MAX_XFER_SECTORS
+				|| (r->sector != end && r->sector + r->cnt != start)) {
+			e = list_next (e);
+			continue;
+		}
+
+		list_remove (e);
+		if (r->sector == end) {
+			list_push_back (batch, e);
+			end += r->cnt;
+		} else {
+			list_push_front (batch, e);
+			start = r->sector;
+		}
+		merged++;
+
+		/* The batch grew, so earlier requests may fit now. */
+		e = list_begin (&c->queue);
+	}
+
+	c->head = position (pick->disk, end);
+}
+
+/* Moves the CNT sectors starting at SEC_NO of the requests in
+   BATCH between disk D and their buffers by bus master DMA,
+   writing to the disk if WRITE is true and reading from it
+   otherwise.  Returns true if successful. */
+static bool
+dma_transfer (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		struct list *batch, bool write) {
+	struct channel *c = d->channel;
+	uint8_t dir = write ? 0 : BMC_READ;
+	uint8_t bm_status;
+	struct list_elem *e;
+	int i = 0;
+
+	ASSERT (cnt > 0 && cnt <= MAX_XFER_SECTORS);
+
+	/* Describe each buffer, splitting it at 64 kB boundaries. */
+	for (e = list_begin (batch); e != list_end (batch); e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		uint64_t addr = vtop (r->buffer);
+		size_t size = r->cnt * DISK_SECTOR_SIZE;
+
+		ASSERT ((addr & 1) == 0);
+		ASSERT (addr + size <= 0x100000000ULL);
+
+		while (size > 0) {
+			size_t chunk = 0x10000 - (addr & 0xffff);
+			if (chunk > size)
+				chunk = size;
+
+			ASSERT (i < PRD_CNT);
+			c->prdt[i].addr = addr;
+			c->prdt[i].size = chunk & 0xffff;
+			c->prdt[i].flags = 0;
+			addr += chunk;
+			size -= chunk;
+			i++;
+		}
+	}
+	c->prdt[i - 1].flags = PRD_EOT;
+
+	/* Program the bus master, then the drive, then start. */
+	outb (c->bm_base + BM_COMMAND, dir);
+	outl (c->bm_base + BM_PRDT, vtop (c->prdt));
+	outb (c->bm_base + BM_STATUS, BMS_ERROR | BMS_INTR);
+	select_sector (d, sec_no, cnt);
+	issue_command (c, write ? CMD_WRITE_DMA : CMD_READ_DMA);
+	outb (c->bm_base + BM_COMMAND, dir | BMC_START);
+
+	/* The drive interrupts once the whole transfer is done. */
 	sema_down (&c->completion_wait);
-	d->write_cnt++;
-	lock_release (&c->lock);
+	bm_status = inb (c->bm_base + BM_STATUS);
+	outb (c->bm_base + BM_COMMAND, dir);
+	outb (c->bm_base + BM_STATUS, BMS_ERROR | BMS_INTR);
+
+	return (bm_status & BMS_ERROR) == 0
+		&& (inb (reg_alt_status (c)) & (STA_BSY | STA_ERR)) == 0;
 }
-
+
+/* Moves the CNT sectors starting at SEC_NO of the requests in
+   BATCH between disk D and their buffers through the data
+   register, as dma_transfer().  The drive interrupts once per
+   sector. */
+static bool
+pio_transfer (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		struct list *batch, bool write) {
+	struct channel *c = d->channel;
+	struct list_elem *e;
+
+	select_sector (d, sec_no, cnt);
+	issue_command (c, write ? CMD_WRITE_SECTOR_RETRY : CMD_READ_SECTOR_RETRY);
+	for (e = list_begin (batch); e != list_end (batch); e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		uint8_t *buffer = r->buffer;
+
+		for (size_t i = 0; i < r->cnt; i++) {
+			if (write) {
+				if (!wait_while_busy (d))
+					return false;
+				output_sector (c, buffer + i * DISK_SECTOR_SIZE);
+				sema_down (&c->completion_wait);
+			} else {
+				sema_down (&c->completion_wait);
+				if (!wait_while_busy (d))
+					return false;
+				input_sector (c, buffer + i * DISK_SECTOR_SIZE);
+			}
+		}
+	}
+	return true;
+}
+
+/* PCI configuration space access, mechanism #1. */
+#define PCI_CONFIG_ADDR 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+
+/* Reads the 32-bit register at REG of PCI function BUS:DEV.FN. */
+static uint32_t
+pci_read (int bus, int dev, int fn, int reg) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | bus << 16 | dev << 11 | fn << 8
+			| (reg & 0xfc));
+	return inl (PCI_CONFIG_DATA);
+}
+
+/* Writes VALUE to the 32-bit register at REG of PCI function
+   BUS:DEV.FN. */
+static void
+pci_write (int bus, int dev, int fn, int reg, uint32_t value) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | bus << 16 | dev << 11 | fn << 8
+			| (reg & 0xfc));
+	outl (PCI_CONFIG_DATA, value);
+}
+
+/* Looks on PCI bus 0 for an IDE controller in legacy mode that can
+   act as a bus master, and if there is one, enables bus mastering
+   and records each channel's bus master ports.  Channels without
+   bus master ports keep using PIO. */
+static void
+find_bus_master (void) {
+	for (int dev = 0; dev < 32; dev++)
+		for (int fn = 0; fn < 8; fn++) {
+			uint32_t id = pci_read (0, dev, fn, 0x00);
+			uint32_t class = pci_read (0, dev, fn, 0x08);
+			uint32_t bar4;
+
+			if ((id & 0xffff) == 0xffff)
+				continue;
+			/* Class 01h (storage), subclass 01h (IDE), both channels
+			   in compatibility mode, bus master capable. */
+			if ((class >> 16) != 0x0101 || (class & 0x8500) != 0x8000)
+				continue;
+			bar4 = pci_read (0, dev, fn, 0x20);
+			if ((bar4 & 1) == 0 || (bar4 & 0xfffc) == 0)
+				continue;
+
+			/* Enable I/O space decoding and bus mastering. */
+			pci_write (0, dev, fn, 0x04, pci_read (0, dev, fn, 0x04) | 0x5);
+			channels[0].bm_base = bar4 & 0xfffc;
+			channels[1].bm_base = (bar4 & 0xfffc) + 8;
+			printf ("disk: bus master IDE at port %#x\n", bar4 & 0xfffc);
+			return;
+		}
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -353,7 +1055,7 @@ identify_ata_device (struct disk *d) {
 	   indicating the device's response is ready, and read the data
 	   into our buffer. */
 	select_device_wait (d);
-	issue_pio_command (c, CMD_IDENTIFY_DEVICE);
+	issue_command (c, CMD_IDENTIFY_DEVICE);
 	sema_down (&c->completion_wait);
 	if (!wait_while_busy (d)) {
 		d->is_ata = false;
@@ -402,17 +1104,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= MAX_XFER_SECTORS);
+	ASSERT (sec_no < d->capacity && cnt <= d->capacity - sec_no);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt & 0xff);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -423,7 +1126,7 @@ select_sector (struct disk *d, disk_sector_t sec_no) {
 /* Writes COMMAND to channel C and prepares for receiving a
    completion interrupt. */
 static void
-issue_pio_command (struct channel *c, uint8_t command) {
+issue_command (struct channel *c, uint8_t command) {
 	/* Interrupts must be enabled or our semaphore will never be
 	   up'd by the completion handler. */
 	ASSERT (intr_get_level () == INTR_ON);
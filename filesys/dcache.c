@@ -0,0 +1,196 @@
+/* dcache.c: 디렉토리 항목 캐시의 구현. */
+/* dcache.c: Implementation of the directory entry cache.
+ *
+ * Maps (directory inode sector, name) to the inode sector the name
+ * refers to, so repeated lookups of the same names never read a
+ * directory block.  Names that were looked up and not found are
+ * cached too, as negative entries, so failed opens are just as
+ * cheap.  Entries come from a fixed pool; when it runs out, the
+ * least recently used entry is reused.
+ *
+ * directory.c keeps the cache coherent: dir_add and dir_remove
+ * update the entry for the name they change, and dir_create drops
+ * everything cached under a sector that is reused for a new
+ * directory. */
+
+#include "filesys/dcache.h"
+#include <hash.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "threads/synch.h"
+
+/* 캐시 항목 수 */
+/* Number of entries in the cache. */
+#define DCACHE_SIZE 256
+
+/* 해시 버킷 수, 2의 거듭제곱 */
+/* Number of hash buckets, a power of 2. */
+#define DCACHE_BUCKETS 64
+
+/* 캐시 항목 하나 */
+/* One cache entry. */
+struct dentry {
+	struct list_elem hash_elem;         /* 버킷 리스트의 요소 / Element in a bucket list. */
+	struct list_elem lru_elem;          /* LRU 리스트의 요소 / Element in the LRU list. */
+	disk_sector_t dir;                  /* 디렉토리의 inode 섹터 / Directory's inode sector. */
+	disk_sector_t sector;               /* 이름이 가리키는 inode 섹터 / Inode sector NAME refers to. */
+	bool negative;                      /* 이름이 없으면 true / True if NAME does not exist. */
+	char name[NAME_MAX + 1];
+};
+
+static struct dentry dentries[DCACHE_SIZE];
+static struct list buckets[DCACHE_BUCKETS];
+static struct list lru;                     /* 앞쪽이 가장 최근 / Most recently used first. */
+static struct list free_dentries;
+static struct lock dcache_lock;
+
+/* 디렉토리 항목 캐시를 초기화합니다. */
+/* Initializes the directory entry cache. */
+void
+dcache_init (void) {
+	size_t i;
+
+	lock_init (&dcache_lock);
+	list_init (&lru);
+	list_init (&free_dentries);
+	for (i = 0; i < DCACHE_BUCKETS; i++)
+		list_init (&buckets[i]);
+	for (i = 0; i < DCACHE_SIZE; i++)
+		list_push_back (&free_dentries, &dentries[i].lru_elem);
+}
+
+/* (DIR, NAME)이 들어가는 버킷 */
+/* Returns the bucket that (DIR, NAME) hashes to. */
+static struct list *
+bucket_of (disk_sector_t dir, const char *name) {
+	uint64_t h = hash_string (name) ^ hash_int (dir);
+	return &buckets[h & (DCACHE_BUCKETS - 1)];
+}
+
+/* (DIR, NAME)의 항목을 찾습니다. dcache_lock을 잡고 있어야 합니다. */
+/* Finds the entry for (DIR, NAME), or returns NULL.  The caller
+ * must hold dcache_lock. */
+static struct dentry *
+find (disk_sector_t dir, const char *name) {
+	struct list *bucket = bucket_of (dir, name);
+	struct list_elem *e;
+
+	for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e)) {
+		struct dentry *d = list_entry (e, struct dentry, hash_elem);
+		if (d->dir == dir && !strcmp (d->name, name))
+			return d;
+	}
+	return NULL;
+}
+
+/* 항목 D를 캐시에서 빼서 빈 항목 리스트로 돌려보냅니다.
+ * 빈 항목은 이름이 비어 있습니다. */
+/* Removes D from the cache and returns it to the free list.  Free
+ * entries have an empty name. */
+static void
+release (struct dentry *d) {
+	d->name[0] = '\0';
+	list_remove (&d->hash_elem);
+	list_remove (&d->lru_elem);
+	list_push_back (&free_dentries, &d->lru_elem);
+}
+
+/* (DIR, NAME)을 SECTOR 또는 없음(NEGATIVE)으로 기록합니다. */
+/* Records (DIR, NAME) as referring to SECTOR, or as not existing
+ * if NEGATIVE. */
+static void
+add (disk_sector_t dir, const char *name, disk_sector_t sector,
+		bool negative) {
+	struct dentry *d;
+
+	if (*name == '\0' || strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dcache_lock);
+	d = find (dir, name);
+	if (d != NULL) {
+		list_remove (&d->lru_elem);
+	} else {
+		/* 빈 항목이 없으면 가장 오래 쓰지 않은 항목을 재사용합니다. */
+		/* Reuse the least recently used entry if none is free. */
+		if (list_empty (&free_dentries))
+			release (list_entry (list_back (&lru), struct dentry, lru_elem));
+		d = list_entry (list_pop_front (&free_dentries), struct dentry,
+				lru_elem);
+		d->dir = dir;
+		strlcpy (d->name, name, sizeof d->name);
+		list_push_front (bucket_of (dir, name), &d->hash_elem);
+	}
+	d->sector = sector;
+	d->negative = negative;
+	list_push_front (&lru, &d->lru_elem);
+	lock_release (&dcache_lock);
+}
+
+/* 디렉토리 DIR에서 NAME을 캐시에서 찾습니다.
+ * 이름이 있으면 *SECTORP에 inode 섹터를 넣고 DCACHE_HIT를 반환합니다. */
+/* Looks up NAME in directory DIR in the cache.  On DCACHE_HIT,
+ * stores the inode sector NAME refers to in *SECTORP. */
+enum dcache_result
+dcache_lookup (disk_sector_t dir, const char *name, disk_sector_t *sectorp) {
+	enum dcache_result result = DCACHE_MISS;
+	struct dentry *d;
+
+	lock_acquire (&dcache_lock);
+	d = find (dir, name);
+	if (d != NULL) {
+		list_remove (&d->lru_elem);
+		list_push_front (&lru, &d->lru_elem);
+		if (d->negative)
+			result = DCACHE_NEGATIVE;
+		else {
+			*sectorp = d->sector;
+			result = DCACHE_HIT;
+		}
+	}
+	lock_release (&dcache_lock);
+	return result;
+}
+
+/* 디렉토리 DIR의 NAME이 inode 섹터 SECTOR를 가리킨다고 기록합니다. */
+/* Records that NAME in directory DIR refers to inode SECTOR. */
+void
+dcache_add (disk_sector_t dir, const char *name, disk_sector_t sector) {
+	add (dir, name, sector, false);
+}
+
+/* 디렉토리 DIR에 NAME이 없다고 기록합니다. */
+/* Records that directory DIR has no entry named NAME. */
+void
+dcache_add_negative (disk_sector_t dir, const char *name) {
+	add (dir, name, 0, true);
+}
+
+/* 디렉토리 DIR의 NAME에 대한 항목을 버립니다. */
+/* Drops the entry for NAME in directory DIR, if any. */
+void
+dcache_invalidate (disk_sector_t dir, const char *name) {
+	struct dentry *d;
+
+	lock_acquire (&dcache_lock);
+	d = find (dir, name);
+	if (d != NULL)
+		release (d);
+	lock_release (&dcache_lock);
+}
+
+/* 디렉토리 DIR 아래의 모든 항목을 버립니다. */
+/* Drops every entry for names in directory DIR. */
+void
+dcache_purge_dir (disk_sector_t dir) {
+	size_t i;
+
+	lock_acquire (&dcache_lock);
+	for (i = 0; i < DCACHE_SIZE; i++) {
+		struct dentry *d = &dentries[i];
+		if (d->dir == dir && d->name[0] != '\0')
+			release (d);
+	}
+	lock_release (&dcache_lock);
+}
@@ -2,14 +2,54 @@
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <hash.h>
+#include <round.h>
+#include <dirent.h>
+#include "filesys/dcache.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 
+/* 디렉토리 파일의 형식.
+ * 블록 0은 헤더이고, 블록 1부터 BUCKET_CNT개는 해시 버킷입니다.
+ * 이름은 해시값으로 버킷 하나에 들어가며, 버킷이 가득 차면 파일 끝에 붙인
+ * 넘침 블록으로 사슬을 잇습니다. 따라서 조회, 추가, 삭제는 평균적으로
+ * 블록 한두 개만 읽습니다. 아직 쓰지 않은 버킷은 구멍이므로 공간을 차지하지 않습니다. */
+/* Directory file layout.
+ *
+ * Block 0 is a header.  Blocks 1 through BUCKET_CNT are hash
+ * buckets: each name lives in the bucket its hash selects, and a
+ * bucket that fills up is chained to overflow blocks appended at
+ * the end of the file.  Lookup, add and remove therefore read one
+ * or two blocks on average instead of scanning the directory.
+ * Buckets never written are holes in the file and take no disk
+ * space. */
+
+/* 디렉토리를 식별합니다. */
+/* Identifies a directory. */
+#define DIR_MAGIC 0x44495248
+
+/* 최소 버킷 수 */
+/* Minimum number of hash buckets. */
+#define DIR_BUCKETS 64
+
+/* 블록 하나에 들어가는 항목 수 */
+/* Entries per directory block. */
+#define DIR_BLOCK_ENTRIES 25
+
+/* 디렉토리 헤더 (블록 0). */
+/* Directory header, in block 0. */
+struct dir_header {
+	unsigned magic;                     /* 매직 넘버 / Magic number. */
+	uint32_t bucket_cnt;                /* 해시 버킷 수 / Number of hash buckets. */
+};
+
 /* A directory. */
 struct dir {
 	struct inode *inode;                /* Backing store. */
 	off_t pos;                          /* 현재 위치 Current position. */
+	uint32_t bucket_cnt;                /* 해시 버킷 수 / Number of hash buckets. */
 };
 
 /* 단일 디렉토리 항목 구조체 */
@@ -20,13 +60,83 @@ struct dir_entry {
 	bool in_use;                        /* 사용 중 여부 / In use or free? */
 };
 
+/* 버킷 블록 또는 넘침 블록. */
+/* A bucket or overflow block. */
+struct dir_block {
+	uint32_t next;                      /* 다음 넘침 블록, 없으면 0 / Next overflow block, 0 if none. */
+	struct dir_entry entries[DIR_BLOCK_ENTRIES];
+	uint8_t unused[DISK_SECTOR_SIZE - sizeof (uint32_t)
+		- DIR_BLOCK_ENTRIES * sizeof (struct dir_entry)];
+};
+
+/* 블록 BLOCK의 IDX번째 항목의 바이트 오프셋 */
+/* Byte offset of entry IDX of block BLOCK. */
+static inline off_t
+entry_ofs (uint32_t block, size_t idx) {
+	return block * DISK_SECTOR_SIZE + offsetof (struct dir_block, entries)
+		+ idx * sizeof (struct dir_entry);
+}
+
+/* DIR에서 블록 BLOCK을 B로 읽어 옵니다.
+ * 파일 끝에 걸친 마지막 블록은 나머지를 0으로 채웁니다.
+ * 블록이 파일 끝 너머에 있으면 빈 블록으로 채우고 false를 반환합니다. */
+/* Reads block BLOCK of DIR into B.  The last block may end short
+ * of a full sector, and its tail reads as zeros.  If the block
+ * lies past end of file, fills B with an empty block and returns
+ * false. */
+static bool
+read_block (const struct dir *dir, uint32_t block, struct dir_block *b) {
+	off_t ofs = block * DISK_SECTOR_SIZE;
+	off_t read = inode_read_at (dir->inode, b, sizeof *b, ofs);
+
+	memset ((uint8_t *) b + read, 0, sizeof *b - read);
+	return read > 0;
+}
+
+/* NAME이 들어갈 버킷 블록의 번호 */
+/* Number of the bucket block that NAME hashes to. */
+static uint32_t
+bucket_of (const struct dir *dir, const char *name) {
+	return 1 + hash_string (name) % dir->bucket_cnt;
+}
+
 /* 주어진 SECTOR에 ENTRY_CNT 개의 항목을 위한 공간을 가진 디렉토리를 생성합니다.
- * 성공하면 true를 반환하고, 실패하면 false를 반환합니다. */
+ * 성공하면 true를 반환하고, 실패하면 false를 반환합니다.
+ * 버킷은 처음 쓰일 때 할당되므로 처음에는 헤더 블록만 차지합니다. */
 /* Creates a directory with space for ENTRY_CNT entries in the
- * given SECTOR.  Returns true if successful, false on failure. */
+ * given SECTOR.  Returns true if successful, false on failure.
+ * Buckets are allocated as they are first written, so a new
+ * directory only takes its header block. */
 bool
 dir_create (disk_sector_t sector, size_t entry_cnt) {
-	return inode_create (sector, entry_cnt * sizeof (struct dir_entry));
+	struct dir_header h;
+	struct inode *inode;
+	bool success;
+
+	ASSERT (sizeof (struct dir_block) == DISK_SECTOR_SIZE);
+
+	journal_begin ();
+	if (!inode_create (sector, 0)) {
+		journal_end ();
+		return false;
+	}
+	dcache_purge_dir (sector);
+	inode = inode_open (sector);
+	if (inode == NULL) {
+		journal_end ();
+		return false;
+	}
+	inode_set_journaled (inode);
+	inode_mark_dir (inode);
+
+	h.magic = DIR_MAGIC;
+	h.bucket_cnt = DIV_ROUND_UP (entry_cnt, DIR_BLOCK_ENTRIES);
+	if (h.bucket_cnt < DIR_BUCKETS)
+		h.bucket_cnt = DIR_BUCKETS;
+	success = inode_write_at (inode, &h, sizeof h, 0) == sizeof h;
+	inode_close (inode);
+	journal_end ();
+	return success;
 }
 
 /* 주어진 INODE에 대해 디렉토리를 열고 반환합니다. 이 디렉토리에 대한 소유권을 가집니다.
@@ -36,9 +146,15 @@ dir_create (disk_sector_t sector, size_t entry_cnt) {
 struct dir *
 dir_open (struct inode *inode) {
 	struct dir *dir = calloc (1, sizeof *dir);
-	if (inode != NULL && dir != NULL) {
+	struct dir_header h;
+
+	if (inode != NULL && dir != NULL
+			&& inode_read_at (inode, &h, sizeof h, 0) == sizeof h
+			&& h.magic == DIR_MAGIC && h.bucket_cnt > 0) {
+		inode_set_journaled (inode);
 		dir->inode = inode;
 		dir->pos = 0;
+		dir->bucket_cnt = h.bucket_cnt;
 		return dir;
 	} else {
 		inode_close (inode);
@@ -94,22 +210,38 @@ dir_get_inode (struct dir *dir) {
 static bool
 lookup (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
-	struct dir_entry e;
-	size_t ofs;
+	struct dir_block *b;
+	uint32_t block;
+	bool found = false;
+	size_t i;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (e.in_use && !strcmp (name, e.name)) {
-			if (ep != NULL)
-				*ep = e;
-			if (ofsp != NULL)
-				*ofsp = ofs;
-			return true;
+	/* 경로의 단계마다 불리므로 블록을 커널 스택에 두지 않습니다. */
+	/* Called at every step of a path walk, so keep the block off
+	 * the kernel stack. */
+	b = malloc (sizeof *b);
+	if (b == NULL)
+		return false;
+
+	for (block = bucket_of (dir, name); block != 0 && !found; block = b->next) {
+		if (!read_block (dir, block, b))
+			break;
+		for (i = 0; i < DIR_BLOCK_ENTRIES; i++) {
+			struct dir_entry *e = &b->entries[i];
+			if (e->in_use && !strcmp (name, e->name)) {
+				if (ep != NULL)
+					*ep = *e;
+				if (ofsp != NULL)
+					*ofsp = entry_ofs (block, i);
+				found = true;
+				break;
+			}
 		}
-	return false;
+	}
+	free (b);
+	return found;
 }
 
 /* DIR에서 주어진 NAME의 파일을 검색하고 존재하면 true를 반환하고 그렇지 않으면 false를 반환합니다.
@@ -122,15 +254,38 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
+	disk_sector_t dir_sector, sector;
 	struct dir_entry e;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
-		*inode = inode_open (e.inode_sector);
-	else
-		*inode = NULL;
+	dir_sector = inode_get_inumber (dir->inode);
+
+	/* 캐시에 있으면 디렉토리 블록을 읽지 않습니다.
+	 * 디렉토리 잠금은 찾은 inode가 열리기 전에 삭제되는 것을 막습니다. */
+	/* Cached answers, positive or negative, need no directory
+	 * block at all.  The directory lock keeps the entry found from
+	 * being removed before its inode is open. */
+	inode_dir_lock (dir->inode);
+	switch (dcache_lookup (dir_sector, name, &sector)) {
+		case DCACHE_HIT:
+			*inode = inode_open (sector);
+			break;
+		case DCACHE_NEGATIVE:
+			*inode = NULL;
+			break;
+		default:
+			if (lookup (dir, name, &e, NULL)) {
+				dcache_add (dir_sector, name, e.inode_sector);
+				*inode = inode_open (e.inode_sector);
+			} else {
+				dcache_add_negative (dir_sector, name);
+				*inode = NULL;
+			}
+			break;
+	}
+	inode_dir_unlock (dir->inode);
 
 	return *inode != NULL;
 }
@@ -148,7 +303,6 @@ dir_lookup (const struct dir *dir, const char *name,
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	struct dir_entry e;
-	off_t ofs;
 	bool success = false;
 
 	ASSERT (dir != NULL);
@@ -159,33 +313,55 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
-	/* NAME이 사용 중이지 않은지 확인합니다. */
-	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
-		goto done;
+	/* NAME이 사용 중이지 않은지 확인하면서 NAME의 버킷 사슬에서 빈 슬롯을 찾습니다.
+	 * 넘침 블록을 잇는 것과 항목을 쓰는 것은 한 트랜잭션에 들어갑니다. */
+	/* Walk NAME's bucket chain, checking that NAME is not in use
+	 * and remembering the first free slot.  Linking in an overflow
+	 * block and writing the entry go in one transaction. */
+	struct dir_block *b = malloc (sizeof *b);
+	if (b == NULL)
+		return false;
+	journal_begin ();
+	inode_dir_lock (dir->inode);
+	uint32_t block = bucket_of (dir, name), last = block;
+	off_t ofs = -1;
+	for (; block != 0; block = b->next) {
+		read_block (dir, block, b);
+		for (size_t i = 0; i < DIR_BLOCK_ENTRIES; i++) {
+			if (!b->entries[i].in_use) {
+				if (ofs < 0)
+					ofs = entry_ofs (block, i);
+			} else if (!strcmp (name, b->entries[i].name))
+				goto done;
+		}
+		last = block;
+	}
 
-	/* OFS를 빈 슬롯의 오프셋으로 설정합니다.
-	 * 빈 슬롯이 없으면 현재 파일 끝으로 설정됩니다.
-	 * inode_read_at()은 파일 끝에서만 짧은 읽기를 반환합니다.
-	 * 그렇지 않으면 낮은 메모리와 같은 일시적인 이유로 인해 짧은 읽기를 얻지 않았는지 확인해야 합니다. */
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
-			break;
+	/* 빈 슬롯이 없으면 파일 끝에 넘침 블록을 붙여 사슬에 잇습니다. */
+	/* If there is no free slot, append an overflow block to the
+	 * file and link it to the end of the chain. */
+	if (ofs < 0) {
+		uint32_t new = DIV_ROUND_UP (inode_length (dir->inode), DISK_SECTOR_SIZE);
+		if (new <= dir->bucket_cnt)
+			new = dir->bucket_cnt + 1;
+		ofs = entry_ofs (new, 0);
+		if (inode_write_at (dir->inode, &new, sizeof new,
+					last * DISK_SECTOR_SIZE) != sizeof new)
+			goto done;
+	}
 
 	/* Write slot. */
 	e.in_use = true;
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	if (success)
+		dcache_add (inode_get_inumber (dir->inode), name, inode_sector);
 
 done:
+	inode_dir_unlock (dir->inode);
+	journal_end ();
+	free (b);
 	return success;
 }
 
@@ -206,6 +382,8 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
+	journal_begin ();
+	inode_dir_lock (dir->inode);
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
 
@@ -216,6 +394,7 @@ dir_remove (struct dir *dir, const char *name) {
 
 	/* Erase directory entry. */
 	e.in_use = false;
+	dcache_invalidate (inode_get_inumber (dir->inode), name);
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
 
@@ -225,6 +404,8 @@ dir_remove (struct dir *dir, const char *name) {
 
 done:
 	inode_close (inode);
+	inode_dir_unlock (dir->inode);
+	journal_end ();
 	return success;
 }
 
@@ -237,12 +418,92 @@ bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
 
-	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
+	/* POS는 다음에 읽을 항목의 오프셋이며, 헤더와 블록 머리를 건너뜁니다. */
+	/* POS is the offset of the next entry to read, skipping the
+	 * header block and each block's link field. */
+	if (dir->pos < entry_ofs (1, 0))
+		dir->pos = entry_ofs (1, 0);
+	while (dir->pos < inode_length (dir->inode)) {
+		uint32_t block = dir->pos / DISK_SECTOR_SIZE;
+		size_t idx = (dir->pos - entry_ofs (block, 0)) / sizeof e;
+
+		if (idx >= DIR_BLOCK_ENTRIES) {
+			dir->pos = entry_ofs (block + 1, 0);
+			continue;
+		}
 		dir->pos += sizeof e;
-		if (e.in_use) {
+		if (inode_read_at (dir->inode, &e, sizeof e, entry_ofs (block, idx))
+				== sizeof e && e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
 			return true;
 		}
 	}
 	return false;
 }
+
+/* DIR의 현재 위치부터 사용 중인 항목을 ENTS에 최대 MAX개까지 채우고, 채운 개수를 반환합니다.
+ * 끝에 다다르면 0을 반환합니다. 블록을 한 번에 읽어 그 안의 항목을 모두 처리하므로
+ * dir_readdir처럼 항목마다 캐시를 거치지 않습니다. */
+/* Fills ENTS with up to MAX in-use entries of DIR, starting at
+ * its current position, and returns the number filled, or 0 at
+ * the end of the directory.  Each block is read from the cache
+ * once and all of its entries are taken from that copy, rather
+ * than one inode_read_at per entry as in dir_readdir. */
+size_t
+dir_getdents (struct dir *dir, struct dirent *ents, size_t max) {
+	struct dir_block *b;
+	size_t cnt = 0;
+
+	b = malloc (sizeof *b);
+	if (b == NULL)
+		return 0;
+
+	if (dir->pos < entry_ofs (1, 0))
+		dir->pos = entry_ofs (1, 0);
+	while (cnt < max && dir->pos < inode_length (dir->inode)) {
+		uint32_t block = dir->pos / DISK_SECTOR_SIZE;
+		size_t idx = (dir->pos - entry_ofs (block, 0)) / sizeof b->entries[0];
+
+		if (!read_block (dir, block, b))
+			break;
+		for (; idx < DIR_BLOCK_ENTRIES && cnt < max; idx++) {
+			const struct dir_entry *e = &b->entries[idx];
+			struct dirent *d = &ents[cnt];
+			struct inode *inode;
+
+			if (!e->in_use)
+				continue;
+			inode = inode_open (e->inode_sector);
+			if (inode == NULL)
+				continue;
+			d->d_ino = e->inode_sector;
+			d->d_size = inode_length (inode);
+			d->d_type = inode_is_dir (inode) ? DT_DIR : DT_REG;
+			strlcpy (d->d_name, e->name, sizeof d->d_name);
+			inode_close (inode);
+			cnt++;
+		}
+		dir->pos = idx < DIR_BLOCK_ENTRIES
+			? entry_ofs (block, idx) : entry_ofs (block + 1, 0);
+	}
+	free (b);
+	return cnt;
+}
+
+/* DIR의 다음 읽기 위치를 POS로 바꿉니다. POS는 dir_tell이 돌려준 값이어야 합니다. */
+/* Sets the position DIR reads from next to POS, which must be a
+ * value returned by dir_tell. */
+void
+dir_seek (struct dir *dir, off_t pos) {
+	ASSERT (dir != NULL);
+	ASSERT (pos >= 0);
+	dir->pos = pos;
+}
+
+/* DIR의 다음 읽기 위치를 반환합니다. */
+/* Returns the position DIR reads from next. */
+off_t
+dir_tell (struct dir *dir) {
+	ASSERT (dir != NULL);
+	return dir->pos;
+}
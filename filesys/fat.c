@@ -3,6 +3,7 @@
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include <bitmap.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -24,7 +25,9 @@ struct fat_fs {
 	unsigned int *fat;
 	unsigned int fat_length;
 	disk_sector_t data_start;
-	cluster_t last_clst;
+	cluster_t last_clst;          /* 다음 빈 클러스터 탐색 시작점 / Next-fit hint for free clusters. */
+	struct bitmap *used;          /* 사용 중인 클러스터 / Clusters in use. */
+	struct bitmap *dirty;         /* 바뀐 FAT 섹터 / FAT sectors changed since load. */
 	struct lock write_lock;
 };
 
@@ -32,6 +35,7 @@ static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_maps_init (void);
 
 void
 fat_init (void) {
@@ -59,27 +63,23 @@ fat_open (void) {
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
 
-	// Load FAT directly from the disk
+	// Load FAT directly from the disk, whole sectors in one transfer
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
 	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i,
-			           buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
-		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
-			free (bounce);
-		}
+	const unsigned full = fat_size_in_bytes / DISK_SECTOR_SIZE;
+	if (full > 0)
+		disk_read_multiple (filesys_disk, fat_fs->bs.fat_start, full, buffer);
+	if (full < fat_fs->bs.fat_sectors
+			&& fat_size_in_bytes % DISK_SECTOR_SIZE != 0) {
+		uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
+		if (bounce == NULL)
+			PANIC ("FAT load failed");
+		disk_read (filesys_disk, fat_fs->bs.fat_start + full, bounce);
+		memcpy (buffer + full * DISK_SECTOR_SIZE, bounce,
+				fat_size_in_bytes % DISK_SECTOR_SIZE);
+		free (bounce);
 	}
+	fat_maps_init ();
 }
 
 void
@@ -90,29 +90,39 @@ fat_close (void) {
 		PANIC ("FAT close failed");
 	memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
-	free (bounce);
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
+	/* 바뀐 FAT 섹터만, 연속된 것끼리 묶어 순서대로 씁니다. */
+	/* Write back only the FAT sectors that changed, one run of
+	 * consecutive dirty sectors at a time, in disk order. */
+	const uint8_t *buffer = (const uint8_t *) fat_fs->fat;
+	const size_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
+	size_t i = 0;
+	while ((i = bitmap_scan (fat_fs->dirty, i, 1, true)) != BITMAP_ERROR) {
+		size_t run = 1;
+		while (i + run < bitmap_size (fat_fs->dirty)
+				&& bitmap_test (fat_fs->dirty, i + run))
+			run++;
+
+		/* 섹터 전체가 FAT 안에 있는 부분은 한 번에 씁니다. */
+		/* Sectors wholly inside the FAT go out in one transfer. */
+		size_t full = 0;
+		while (full < run
+				&& (i + full + 1) * DISK_SECTOR_SIZE <= fat_size_in_bytes)
+			full++;
+		if (full > 0)
+			disk_write_multiple (filesys_disk, fat_fs->bs.fat_start + i, full,
+					buffer + i * DISK_SECTOR_SIZE);
+		for (size_t j = i + full; j < i + run; j++) {
+			size_t ofs = j * DISK_SECTOR_SIZE;
+			memset (bounce, 0, DISK_SECTOR_SIZE);
+			if (ofs < fat_size_in_bytes)
+				memcpy (bounce, buffer + ofs, fat_size_in_bytes - ofs);
+			disk_write (filesys_disk, fat_fs->bs.fat_start + j, bounce);
 		}
+		bitmap_set_multiple (fat_fs->dirty, i, run, false);
+		i += run;
 	}
+	free (bounce);
 }
 
 void
@@ -125,6 +135,11 @@ fat_create (void) {
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_maps_init ();
+
+	/* 디스크의 FAT는 아직 쓰레기이므로 전부 써야 합니다. */
+	/* The FAT on disk is still garbage, so all of it must be written. */
+	bitmap_set_all (fat_fs->dirty, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -154,22 +169,84 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	/* 데이터 영역은 FAT 바로 뒤에서 시작하고, 클러스터 0은 "없음"을 뜻하므로
+	 * 클러스터 1이 데이터 영역의 첫 클러스터입니다. */
+	/* The data area starts right after the FAT.  Cluster 0 means
+	 * "no cluster", so cluster 1 is the first cluster of the data
+	 * area. */
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors - fat_fs->data_start)
+		/ SECTORS_PER_CLUSTER + 1;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER + 1;
+	lock_init (&fat_fs->write_lock);
+}
+
+/* 메모리에 올라온 FAT로부터 사용 중인 클러스터 비트맵과 바뀐 섹터 비트맵을 만듭니다. */
+/* Builds the bitmap of clusters in use from the FAT in memory,
+ * and an all-clean bitmap of dirty FAT sectors. */
+static void
+fat_maps_init (void) {
+	/* 포맷 직후 다시 열 때는 이전 비트맵을 버립니다. */
+	/* Reopening right after a format drops the old bitmaps. */
+	bitmap_destroy (fat_fs->used);
+	bitmap_destroy (fat_fs->dirty);
+	fat_fs->used = bitmap_create (fat_fs->fat_length);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->used == NULL || fat_fs->dirty == NULL)
+		PANIC ("FAT bitmaps allocation failed");
+
+	bitmap_mark (fat_fs->used, 0);
+	for (cluster_t clst = 1; clst < fat_fs->fat_length; clst++)
+		if (fat_fs->fat[clst] != 0)
+			bitmap_mark (fat_fs->used, clst);
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* CLST의 FAT 항목을 VAL로 바꾸고 항목이 든 섹터를 바뀐 것으로 표시합니다.
+ * write_lock을 잡고 있어야 합니다. */
+/* Sets CLST's FAT entry to VAL and marks the FAT sector that holds
+ * it dirty.  The caller must hold write_lock. */
+static void
+fat_set (cluster_t clst, cluster_t val) {
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+
+	fat_fs->fat[clst] = val;
+	bitmap_set (fat_fs->used, clst, val != 0);
+	bitmap_mark (fat_fs->dirty,
+			clst * sizeof (cluster_t) / DISK_SECTOR_SIZE);
+}
+
 /* 체인에 클러스터 추가.
  * CLST가 0이면 새 체인 시작.
- * 새 클러스터를 할당하지 못하면 0을 반환. */
+ * 새 클러스터를 할당하지 못하면 0을 반환.
+ * 빈 클러스터는 비트맵에서 마지막으로 할당한 곳부터 찾습니다(next-fit). */
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
- * Returns 0 if fails to allocate a new cluster. */
+ * Returns 0 if fails to allocate a new cluster.
+ * The free cluster is found in the in-memory bitmap, scanning
+ * from just past the last allocation and wrapping around. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	size_t new;
+
+	lock_acquire (&fat_fs->write_lock);
+	new = bitmap_scan (fat_fs->used, fat_fs->last_clst, 1, false);
+	if (new == BITMAP_ERROR)
+		new = bitmap_scan (fat_fs->used, 1, 1, false);
+	if (new == BITMAP_ERROR) {
+		lock_release (&fat_fs->write_lock);
+		return 0;
+	}
+
+	fat_set (new, EOChain);
+	if (clst != 0)
+		fat_set (clst, new);
+	fat_fs->last_clst = new + 1 < fat_fs->fat_length ? new + 1 : 1;
+	lock_release (&fat_fs->write_lock);
+	return new;
 }
 
 /* CLST부터 시작하는 클러스터 체인 제거.
@@ -178,26 +255,38 @@ fat_create_chain (cluster_t clst) {
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_fs->fat[clst];
+		fat_set (clst, 0);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* FAT 테이블에서 값을 업데이트. */
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	fat_set (clst, val);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* FAT 테이블에서 값 가져오기 */
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	return fat_fs->fat[clst];
 }
 
 /* 클러스터 번호를 섹터 번호로 변환하기 */
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
 }
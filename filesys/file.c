@@ -2,6 +2,12 @@
 #include <debug.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+
+/* 미리 읽기 창의 처음 크기와 최대 크기 (바이트) */
+/* Initial and maximum size of the read-ahead window, in bytes. */
+#define RA_MIN_WINDOW (4 * 1024)
+#define RA_MAX_WINDOW (32 * 1024)
+
 /* 열린 파일. */
 /* An open file. */
 struct file {
@@ -11,8 +17,19 @@ struct file {
                                 /* Current position. */
 	bool deny_write;            /* file_deny_write()가 호출되었는지 여부. */
                                 /* Has file_deny_write() been called? */
+
+	/* 미리 읽기 상태 */
+	/* Read-ahead state. */
+	off_t ra_next;              /* 순차 읽기라면 다음 읽기가 시작할 위치. */
+                                /* Where the next read starts if sequential. */
+	off_t ra_window;            /* 미리 읽을 양, 0이면 미리 읽지 않음. */
+                                /* Bytes to read ahead, 0 if not sequential. */
+	off_t ra_end;               /* 미리 읽기를 요청한 끝. */
+                                /* End of the data read ahead so far. */
 };
 
+static void file_readahead (struct file *, bool sequential);
+
 /* 주어진 INODE에 대해 파일을 열고 소유권을 가집니다.
  * 새 파일을 반환합니다. 할당 실패 또는 INODE가 null인 경우 null 포인터를 반환합니다. */
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -25,6 +42,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ra_next = file->ra_window = file->ra_end = 0;
 		return file;
 	} else {
 		inode_close (inode);
@@ -50,7 +68,7 @@ struct file *
 file_duplicate (struct file *file) {
 	struct file *nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
-		nfile->pos = file->pos;
+		nfile->pos = nfile->ra_next = nfile->ra_end = file->pos;
 		if (file->deny_write)
 			file_deny_write (nfile);
 	}
@@ -87,11 +105,73 @@ file_get_inode (struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
+	bool sequential = file->pos == file->ra_next;
 	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
+	file_readahead (file, sequential);
 	return bytes_read;
 }
 
+/* 직전 읽기가 SEQUENTIAL이었다면 미리 읽기 창을 두 배로 키우고(최대 RA_MAX_WINDOW)
+ * 현재 위치부터 창 끝까지 중 아직 요청하지 않은 부분을 미리 읽습니다.
+ * 순차 읽기가 끊기면 창을 닫습니다. */
+/* Updates FILE's read-ahead state after a read.  If the read was
+ * SEQUENTIAL, doubles the window, up to RA_MAX_WINDOW, and asks
+ * for the part of [pos, pos + window) that was not requested yet.
+ * A non-sequential read closes the window. */
+static void
+file_readahead (struct file *file, bool sequential) {
+	file->ra_next = file->pos;
+	if (!sequential) {
+		file->ra_window = 0;
+		file->ra_end = file->pos;
+		return;
+	}
+
+	if (file->ra_window == 0)
+		file->ra_window = RA_MIN_WINDOW;
+	else if (file->ra_window < RA_MAX_WINDOW)
+		file->ra_window *= 2;
+
+	off_t start = file->ra_end > file->pos ? file->ra_end : file->pos;
+	off_t end = file->pos + file->ra_window;
+	if (start < end) {
+		inode_readahead (file->inode, start, end - start);
+		file->ra_end = end;
+	}
+}
+
+/* FILE의 현재 위치에서 SIZE 바이트를 SINK에 넘기고, 넘긴 만큼 위치를 진행시킵니다.
+ * 데이터는 버퍼 캐시에서 바로 넘기므로 중간 버퍼를 거치지 않습니다. file_read처럼
+ * 순차 접근이면 미리 읽습니다. 넘긴 바이트 수를 반환합니다. */
+/* Hands SIZE bytes of FILE, starting at the file's current
+ * position, to SINK straight from the buffer cache, and advances
+ * the position by the number of bytes SINK took.  Reads ahead
+ * like file_read while the access stays sequential.  Returns the
+ * number of bytes SINK took. */
+off_t
+file_transfer (struct file *file, off_t size, inode_sink_func *sink,
+		void *aux) {
+	off_t bytes_sent = 0;
+
+	/* 창이 자랄 수 있도록 가장 작은 미리 읽기 창 단위로 나눠 넘깁니다. */
+	/* Go in steps of the smallest read-ahead window, so that the
+	 * window gets to grow. */
+	while (size > 0) {
+		bool sequential = file->pos == file->ra_next;
+		off_t chunk = size < RA_MIN_WINDOW ? size : RA_MIN_WINDOW;
+		off_t n = inode_transfer (file->inode, chunk, file->pos, sink, aux);
+
+		file->pos += n;
+		bytes_sent += n;
+		size -= n;
+		file_readahead (file, sequential);
+		if (n < chunk)
+			break;
+	}
+	return bytes_sent;
+}
+
 /* FILE에서 SIZE 바이트를 BUFFER로 읽어옵니다.
  * 파일의 FILE_OFS 오프셋에서 시작합니다.
  * 실제로 읽은 바이트 수를 반환합니다.
@@ -110,19 +190,18 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
 /* FILE에 BUFFER에서 SIZE 바이트를 씁니다.
  * 파일의 현재 위치에서 시작합니다.
  * 실제로 쓴 바이트 수를 반환합니다.
- * 파일 끝에 도달하면 SIZE보다 적을 수 있습니다.
- * (일반적으로 이 경우 파일을 확장해야 하지만, 파일 확장은 아직 구현되지 않았습니다.)
+ * 디스크가 가득 차면 SIZE보다 적을 수 있습니다.
+ * 파일 끝을 넘어 쓰면 파일이 확장됩니다.
  * 읽은 바이트 수만큼 FILE의 위치를 ​​진행시킵니다. */
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
+ * which may be less than SIZE if the disk fills up.
+ * Writing past end of file extends the file.
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
-	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+	off_t bytes_written = file_write_at (file, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
 }
@@ -130,22 +209,40 @@ file_write (struct file *file, const void *buffer, off_t size) {
 /* FILE에 BUFFER에서 SIZE 바이트를 씁니다.
  * 파일의 FILE_OFS 오프셋에서 시작합니다.
  * 실제로 쓴 바이트 수를 반환합니다.
- * 파일 끝에 도달하면 SIZE보다 적을 수 있습니다.
- * (일반적으로 이 경우 파일을 확장해야 하지만, 파일 확장은 아직 구현되지 않았습니다.)
+ * 디스크가 가득 차면 SIZE보다 적을 수 있습니다.
+ * 파일 끝을 넘어 쓰면 파일이 확장됩니다.
  * 파일의 현재 위치는 영향을 받지 않습니다. */
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
- * The file's current position is unaffected. */
+ * which may be less than SIZE if the disk fills up.
+ * Writing past end of file extends the file.
+ * The file's current position is unaffected.
+ * 디렉토리는 디렉토리 계층을 통해서만 바뀌므로 쓰지 않고 0을 반환합니다. */
+/* Directories only change through the directory layer, so
+ * nothing is written to one and 0 is returned. */
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
 		off_t file_ofs) {
+	if (inode_is_dir (file->inode))
+		return 0;
 	return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* FILE의 FILE_OFS부터 SIZE 바이트에 구멍을 뚫습니다. 그 범위는 0으로 읽히고,
+ * 온전히 들어가는 섹터는 해제됩니다. 파일 크기와 현재 위치는 바뀌지 않습니다.
+ * 성공하면 true를 반환합니다. */
+/* Punches a hole of SIZE bytes in FILE at offset FILE_OFS: the
+ * range reads as zeros afterward, and the disk sectors wholly
+ * inside it are released.  The file's size and current position
+ * are unaffected.  Returns true if successful. */
+bool
+file_punch_hole (struct file *file, off_t file_ofs, off_t size) {
+	if (inode_is_dir (file->inode))
+		return false;
+	return inode_punch_hole (file->inode, file_ofs, size);
+}
+
 /* file_allow_write()가 호출되거나 FILE이 닫힐 때까지
  * FILE의 기본 inode에 대한 쓰기 작업을 방지합니다. */
 /* Prevents write operations on FILE's underlying inode
@@ -5,7 +5,10 @@
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 #include "filesys/directory.h"
+#include "filesys/dcache.h"
+#include "filesys/page_cache.h"
 #include "devices/disk.h"
 
 
@@ -13,10 +16,31 @@
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
 
-/* 파일 시스템 락 */
-struct lock filesys_lock;
+/* 스트라이프 단위 (섹터 수). -stripe 옵션으로 정하며, 0이면 스트라이프하지 않습니다. */
+/* Stripe unit in sectors, set with the -stripe option.  0 means
+ * no striping. */
+disk_sector_t filesys_stripe_unit;
+
+/* 스트라이프 위에 만든 스왑 영역. 스왑이 자기 디스크를 쓰면 NULL입니다. */
+/* Swap area on the stripe, or NULL if swap has a disk of its
+ * own. */
+struct disk *filesys_swap_disk;
+
+/* 파일 시스템을 담을 RAM 디스크의 크기 (MB). -ramfs 옵션으로 정하며, 0이면 hd0:1을 씁니다. */
+/* Size in MB of a RAM disk to hold the file system, set with the
+ * -ramfs option.  0 means the file system is on hd0:1. */
+size_t filesys_ram_mb;
+
+/* -crash 옵션으로 정합니다. 참이면 저널의 로그를 제자리에 반영하지 않고, 종료할 때도
+ * 로그만 쓰고 캐시는 버려서 충돌한 것처럼 둡니다. 다음 부팅에서 로그를 다시 적용합니다. */
+/* Set with the -crash option.  If true, the journal never writes
+ * its log back home, and at power off only the log is written and
+ * the cache is dropped, as in a crash.  The next boot replays the
+ * log. */
+bool filesys_crash;
 
 static void do_format (void);
+static void stripe_disks (void);
 
 /* 파일 시스템 모듈을 초기화합니다.
  * FORMAT이 true이면 파일 시스템을 다시 포맷합니다. */
@@ -24,11 +48,25 @@ static void do_format (void);
  * If FORMAT is true, reformats the file system. */
 void
 filesys_init (bool format) {
-	filesys_disk = disk_get (0, 1);
+	if (filesys_ram_mb > 0) {
+		/* RAM 디스크는 비어 있는 채로 시작하므로 항상 포맷합니다. */
+		/* A RAM disk starts out empty, so it is always formatted.
+		   Its contents are gone at power off. */
+		filesys_disk = disk_ram (filesys_ram_mb
+				* (1024 * 1024 / DISK_SECTOR_SIZE));
+		if (filesys_disk == NULL)
+			PANIC ("out of memory for a %zu MB RAM disk", filesys_ram_mb);
+		format = true;
+	} else if (filesys_stripe_unit > 0)
+		stripe_disks ();
+	else
+		filesys_disk = disk_get (0, 1);
 	if (filesys_disk == NULL)
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
+	page_cache_init ();
 	inode_init ();
+	dcache_init ();
 
 #ifdef EFILESYS
 	fat_init ();
@@ -45,10 +83,11 @@ filesys_init (bool format) {
 	if (format)
 		do_format ();
 
+	/* 저널을 다시 적용한 뒤에야 프리 맵을 읽을 수 있습니다. */
+	/* The journal must be replayed before the free map is read. */
+	journal_open ();
 	free_map_open ();
 #endif
-	/* 파일 시스템 락 초기화 */
-	lock_init(&filesys_lock);
 }
 
 /* 파일 시스템 모듈을 종료하고, 기록되지 않은 데이터를 디스크에 씁니다. */
@@ -61,8 +100,12 @@ filesys_done (void) {
 #ifdef EFILESYS
 	fat_close ();
 #else
+	journal_close ();
+	if (filesys_crash)
+		return;
 	free_map_close ();
 #endif
+	page_cache_flush ();
 }
 
 /* 주어진 INITIAL_SIZE로 NAME이라는 파일을 생성합니다.
@@ -75,6 +118,7 @@ filesys_done (void) {
 bool
 filesys_create (const char *name, off_t initial_size) {
 	disk_sector_t inode_sector = 0;
+	journal_begin ();
 	struct dir *dir = dir_open_root ();
 	bool success = (dir != NULL
 			&& free_map_allocate (1, &inode_sector)
@@ -83,25 +127,32 @@ filesys_create (const char *name, off_t initial_size) {
 	if (!success && inode_sector != 0)
 		free_map_release (inode_sector, 1);
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
 
 /* 주어진 NAME의 파일을 엽니다.
  * 성공하면 새 파일을 반환하고, 그렇지 않으면 null 포인터를 반환합니다.
- * NAME이라는 파일이 존재하지 않거나 내부 메모리 할당에 실패하면 실패합니다. */
+ * NAME이라는 파일이 존재하지 않거나 내부 메모리 할당에 실패하면 실패합니다.
+ * NAME이 "/"이면 getdents로 읽을 수 있도록 루트 디렉토리를 엽니다. */
 /* Opens the file with the given NAME.
  * Returns the new file if successful or a null pointer
  * otherwise.
  * Fails if no file named NAME exists,
- * or if an internal memory allocation fails. */
+ * or if an internal memory allocation fails.
+ * NAME "/" opens the root directory, for reading with getdents. */
 struct file *
 filesys_open (const char *name) {
 	struct dir *dir = dir_open_root ();
 	struct inode *inode = NULL;
 
-	if (dir != NULL)
-		dir_lookup (dir, name, &inode);
+	if (dir != NULL) {
+		if (!strcmp (name, "/"))
+			inode = inode_reopen (dir_get_inode (dir));
+		else
+			dir_lookup (dir, name, &inode);
+	}
 	dir_close (dir);
 
 	return file_open (inode);
@@ -116,9 +167,11 @@ filesys_open (const char *name) {
  * or if an internal memory allocation fails. */
 bool
 filesys_remove (const char *name) {
+	journal_begin ();
 	struct dir *dir = dir_open_root ();
 	bool success = dir != NULL && dir_remove (dir, name);
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
@@ -138,8 +191,41 @@ do_format (void) {
 	free_map_create ();
 	if (!dir_create (ROOT_DIR_SECTOR, 16))
 		PANIC ("root directory creation failed");
+	journal_create ();
 	free_map_close ();
 #endif
 
 	printf ("done.\n");
 }
+
+/* hd0:1과 hd1:1을 FILESYS_STRIPE_UNIT 섹터 단위로 번갈아 묶고, 앞쪽 절반은 파일 시스템에,
+ * 뒤쪽 절반은 스왑에 줍니다. 두 디스크는 서로 다른 채널에 있으므로 큰 전송은 두 채널에서
+ * 동시에 진행됩니다. 각 절반은 작은 쪽 디스크만큼의 용량을 가집니다. */
+/* Stripes hd0:1 and hd1:1 together, FILESYS_STRIPE_UNIT sectors
+ * at a time, and gives the first half of the result to the file
+ * system and the second half to swap.  The two disks are on
+ * different channels, so large transfers proceed on both at
+ * once.  Each half holds as much as the smaller disk. */
+static void
+stripe_disks (void) {
+	struct disk *members[2] = { disk_get (0, 1), disk_get (1, 1) };
+	struct disk *stripe;
+	disk_sector_t half;
+
+	if (members[0] == NULL || members[1] == NULL)
+		PANIC ("-stripe needs both hd0:1 (hdb) and hd1:1 (hdd)");
+	stripe = disk_stripe (members, 2, filesys_stripe_unit);
+	if (stripe == NULL)
+		PANIC ("out of memory for the striped disk");
+	half = disk_size (stripe) / 2;
+	if (half == 0)
+		PANIC ("disks too small for a stripe unit of %"PRDSNu" sectors",
+				filesys_stripe_unit);
+
+	filesys_disk = disk_slice (stripe, 0, half);
+	filesys_swap_disk = disk_slice (stripe, half, half);
+	if (filesys_disk == NULL || filesys_swap_disk == NULL)
+		PANIC ("out of memory for the striped disk");
+	printf ("Striping hd0:1 and hd1:1 in units of %"PRDSNu" sectors.\n",
+			filesys_stripe_unit);
+}
@@ -1,22 +1,51 @@
 #include "filesys/free-map.h"
 #include <bitmap.h>
 #include <debug.h>
+#include <round.h>
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* 프리 맵 파일의 한 섹터가 나타내는 섹터 수. 할당 그룹 하나의 크기입니다. */
+/* Sectors covered by one sector of the free map file, which is
+ * also the size of an allocation group. */
+#define GROUP_SECTORS (DISK_SECTOR_SIZE * 8)
+
 static struct file *free_map_file;   /* 프리 맵 파일. / Free map file */
 static struct bitmap *free_map;      /* 프리 맵, 디스크 섹터당 하나의 비트. / Free map, one bit per disk sector. */
+static struct bitmap *dirty_groups;  /* 디스크에 쓰지 않은 변경이 있는 그룹. / Groups with changes not yet written. */
+static uint16_t *free_cnts;          /* 그룹별 빈 섹터 수. / Free sectors in each group. */
+static size_t group_cnt;             /* 할당 그룹 수. / Number of allocation groups. */
+static disk_sector_t next_fit;       /* 다음 할당을 찾기 시작할 섹터. / Where the next allocation looks first. */
+static struct lock free_map_lock;    /* 위의 모든 것을 보호합니다. / Protects all of the above. */
+
+static void count_free (void);
+static size_t scan_from (size_t start, size_t cnt);
+static size_t find_free (size_t goal, size_t cnt);
+static void set_used (disk_sector_t sector, size_t cnt, bool used);
 
 /* 프리 맵을 초기화합니다. */
 /* Initializes the free map. */
 void
 free_map_init (void) {
+	lock_init (&free_map_lock);
 	free_map = bitmap_create (disk_size (filesys_disk));
 	if (free_map == NULL)
 		PANIC ("비트맵 생성 실패--디스크가 너무 큼");
 	/* PANIC ("bitmap creation failed--disk is too large"); */
-	bitmap_mark (free_map, FREE_MAP_SECTOR);
-	bitmap_mark (free_map, ROOT_DIR_SECTOR);
+	group_cnt = DIV_ROUND_UP (bitmap_size (free_map), GROUP_SECTORS);
+	dirty_groups = bitmap_create (group_cnt);
+	free_cnts = malloc (group_cnt * sizeof *free_cnts);
+	if (dirty_groups == NULL || free_cnts == NULL)
+		PANIC ("비트맵 생성 실패--디스크가 너무 큼");
+	/* PANIC ("bitmap creation failed--disk is too large"); */
+	count_free ();
+	set_used (FREE_MAP_SECTOR, 1, true);
+	set_used (ROOT_DIR_SECTOR, 1, true);
+	set_used (JOURNAL_SECTOR, 1 + JOURNAL_LOG_SECTORS, true);
 }
 
 /* 프리 맵에서 CNT개의 연속된 섹터를 할당하고
@@ -28,25 +57,90 @@ free_map_init (void) {
  * available. */
 bool
 free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
-	disk_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-	if (sector != BITMAP_ERROR
-			&& free_map_file != NULL
-			&& !bitmap_write (free_map, free_map_file)) {
-		bitmap_set_multiple (free_map, sector, cnt, false);
-		sector = BITMAP_ERROR;
+	lock_acquire (&free_map_lock);
+	size_t sector = find_free (next_fit, cnt);
+	if (sector != BITMAP_ERROR) {
+		set_used (sector, cnt, true);
+		next_fit = sector + cnt;
 	}
+	lock_release (&free_map_lock);
 	if (sector != BITMAP_ERROR)
 		*sectorp = sector;
 	return sector != BITMAP_ERROR;
 }
 
-/* SECTOR부터 시작하는 CNT 섹터를 사용 가능하게 만듭니다. */
-/* Makes CNT sectors starting at SECTOR available for use. */
+/* 가능하면 GOAL 이후에서, 최대 CNT개의 연속된 섹터를 할당합니다.
+ * CNT개짜리 빈 공간이 없으면 절반씩 줄여 가며 찾습니다.
+ * 첫 섹터를 *SECTORP에, 할당한 섹터 수를 *CNTP에 저장합니다.
+ * 빈 섹터가 하나도 없으면 false를 반환합니다. */
+/* Allocates a run of at most CNT consecutive sectors, preferably
+ * at or after GOAL, so that a growing file stays contiguous.  If
+ * no run of CNT sectors is free, tries half as many, and so on.
+ * Stores the first sector into *SECTORP and the number of sectors
+ * allocated into *CNTP.  Returns false if the disk is full. */
+bool
+free_map_allocate_near (disk_sector_t goal, size_t cnt,
+		disk_sector_t *sectorp, size_t *cntp) {
+	bool success = false;
+
+	lock_acquire (&free_map_lock);
+	for (; cnt > 0; cnt /= 2) {
+		size_t sector = find_free (goal, cnt);
+		if (sector == BITMAP_ERROR)
+			continue;
+
+		set_used (sector, cnt, true);
+		*sectorp = sector;
+		*cntp = cnt;
+		success = true;
+		break;
+	}
+	lock_release (&free_map_lock);
+	return success;
+}
+
+/* SECTOR부터 시작하는 CNT 섹터를 사용 가능하게 만듭니다.
+ * 저널을 쓰면 실행 중인 트랜잭션이 커밋될 때 해제됩니다. */
+/* Makes CNT sectors starting at SECTOR available for use.  With
+ * the journal on, that happens when the running transaction
+ * commits, see journal_release. */
 void
 free_map_release (disk_sector_t sector, size_t cnt) {
-	ASSERT (bitmap_all (free_map, sector, cnt));
-	bitmap_set_multiple (free_map, sector, cnt, false);
-	bitmap_write (free_map, free_map_file);
+	if (!journal_release (sector, cnt))
+		free_map_release_now (sector, cnt);
+}
+
+/* SECTOR부터 시작하는 CNT 섹터를 바로 사용 가능하게 만듭니다. */
+/* Makes CNT sectors starting at SECTOR available for use at
+ * once. */
+void
+free_map_release_now (disk_sector_t sector, size_t cnt) {
+	lock_acquire (&free_map_lock);
+	set_used (sector, cnt, false);
+	lock_release (&free_map_lock);
+}
+
+/* 바뀐 그룹에 해당하는 프리 맵 파일의 섹터들만 씁니다. 연속된 그룹들은 한 번에 씁니다. */
+/* Writes the sectors of the free map file whose groups changed
+ * since they were last written, each run of them at once.  The
+ * free map is otherwise only written at free_map_close. */
+void
+free_map_sync (void) {
+	lock_acquire (&free_map_lock);
+	if (free_map_file != NULL) {
+		size_t g = 0;
+
+		while ((g = bitmap_scan (dirty_groups, g, 1, true)) != BITMAP_ERROR) {
+			size_t end = bitmap_scan (dirty_groups, g, 1, false);
+			if (end == BITMAP_ERROR)
+				end = group_cnt;
+			if (bitmap_write_part (free_map, free_map_file,
+						g * DISK_SECTOR_SIZE, (end - g) * DISK_SECTOR_SIZE))
+				bitmap_set_multiple (dirty_groups, g, end - g, false);
+			g = end;
+		}
+	}
+	lock_release (&free_map_lock);
 }
 
 /* 프리 맵 파일을 열고 디스크에서 읽습니다. */
@@ -57,16 +151,20 @@ free_map_open (void) {
 	if (free_map_file == NULL)
 		PANIC ("프리 맵을 열 수 없음");
 	/* PANIC ("can't open free map"); */
+	inode_set_journaled (file_get_inode (free_map_file));
 	if (!bitmap_read (free_map, free_map_file))
 		PANIC ("프리 맵을 읽을 수 없음");
 	/* PANIC ("can't read free map"); */
+	count_free ();
 }
 
 /* 프리 맵을 디스크에 쓰고 프리 맵 파일을 닫습니다. */
 /* Writes the free map to disk and closes the free map file. */
 void
 free_map_close (void) {
+	free_map_sync ();
 	file_close (free_map_file);
+	free_map_file = NULL;
 }
 
 /* 디스크에 새 프리 맵 파일을 생성하고 프리 맵을 씁니다. */
@@ -86,7 +184,91 @@ free_map_create (void) {
 	if (free_map_file == NULL)
 		PANIC ("프리 맵을 열 수 없음");
 	/* PANIC ("can't open free map"); */
+	inode_set_journaled (file_get_inode (free_map_file));
 	if (!bitmap_write (free_map, free_map_file))
 		PANIC ("프리 맵을 쓸 수 없음");
 	/* PANIC ("can't write free map"); */
+	bitmap_set_all (dirty_groups, false);
+}
+
+/* 프리 맵에서 그룹별 빈 섹터 수를 다시 셉니다. 쓸 것은 없다고 표시합니다. */
+/* Recounts the free sectors of each group from the free map, and
+ * marks every group clean. */
+static void
+count_free (void) {
+	size_t bit_cnt = bitmap_size (free_map);
+
+	for (size_t g = 0; g < group_cnt; g++) {
+		size_t start = g * GROUP_SECTORS;
+		size_t cnt = bit_cnt - start < GROUP_SECTORS
+			? bit_cnt - start : GROUP_SECTORS;
+		free_cnts[g] = bitmap_count (free_map, start, cnt, false);
+	}
+	bitmap_set_all (dirty_groups, false);
+}
+
+/* START 이후에서 CNT개의 빈 섹터가 연속된 첫 위치를 반환합니다. 없으면 BITMAP_ERROR.
+ * 그 위치에서 시작할 수 없는 그룹은 그룹별 빈 섹터 수만 보고 건너뜁니다. */
+/* Returns the first sector of a run of CNT free sectors at or
+ * after START, or BITMAP_ERROR if there is none.  Groups where
+ * such a run cannot start are skipped by their free counts alone,
+ * without looking at the bitmap. */
+static size_t
+scan_from (size_t start, size_t cnt) {
+	for (size_t g = start / GROUP_SECTORS; g < group_cnt; g++) {
+		/* 그룹 하나보다 짧은 구간은 이 그룹과 다음 그룹 안에 들어갑니다. */
+		/* A run no longer than a group lies within this group and
+		 * the next one. */
+		size_t avail = free_cnts[g];
+		if (cnt <= GROUP_SECTORS && g + 1 < group_cnt)
+			avail += free_cnts[g + 1];
+		if (free_cnts[g] == 0 || (cnt <= GROUP_SECTORS && avail < cnt))
+			continue;
+
+		if (start < g * GROUP_SECTORS)
+			start = g * GROUP_SECTORS;
+		return bitmap_scan (free_map, start, cnt, false);
+	}
+	return BITMAP_ERROR;
+}
+
+/* GOAL부터 디스크 끝까지, 이어서 디스크 처음부터 CNT개의 빈 섹터를 찾습니다. */
+/* Looks for CNT free sectors from GOAL to the end of the disk,
+ * then from the start of the disk. */
+static size_t
+find_free (size_t goal, size_t cnt) {
+	size_t sector;
+
+	if (goal >= bitmap_size (free_map))
+		goal = 0;
+	sector = scan_from (goal, cnt);
+	if (sector == BITMAP_ERROR && goal != 0)
+		sector = scan_from (0, cnt);
+	return sector;
+}
+
+/* SECTOR부터 CNT개의 섹터를 USED로 표시하고, 그룹별 빈 섹터 수와 더러운 그룹을
+ * 갱신합니다. 섹터들은 모두 반대 상태여야 합니다. free_map_lock을 잡은 상태여야 합니다. */
+/* Marks CNT sectors starting at SECTOR as USED, all of which must
+ * currently be the opposite, and updates the free counts and the
+ * dirty groups.  free_map_lock must be held, except during
+ * free_map_init. */
+static void
+set_used (disk_sector_t sector, size_t cnt, bool used) {
+	size_t end = sector + cnt;
+
+	ASSERT (!bitmap_contains (free_map, sector, cnt, used));
+	bitmap_set_multiple (free_map, sector, cnt, used);
+	for (size_t s = sector; s < end; ) {
+		size_t g = s / GROUP_SECTORS;
+		size_t next = (g + 1) * GROUP_SECTORS < end
+			? (g + 1) * GROUP_SECTORS : end;
+
+		if (used)
+			free_cnts[g] -= next - s;
+		else
+			free_cnts[g] += next - s;
+		bitmap_mark (dirty_groups, g);
+		s = next;
+	}
 }
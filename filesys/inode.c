@@ -1,29 +1,103 @@
 #include "filesys/inode.h"
 #include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* inode를 식별합니다. */
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* inode 안에 직접 담는 익스텐트 수와 넘침 블록 하나에 담는 익스텐트 수 */
+/* Extents stored in the inode itself, and in each overflow block. */
+#define INODE_EXTENTS 41
+#define BLOCK_EXTENTS 42
+
+/* inode 섹터 안에 데이터를 담는 파일의 최대 크기. 익스텐트 자리를 씁니다. */
+/* Largest file whose data is kept inline in its inode sector, in
+ * the space of the extents. */
+#define INODE_INLINE_MAX (INODE_EXTENTS * sizeof (struct extent))
+
+/* struct inode_disk의 FLAGS 비트 */
+/* Bits of FLAGS in struct inode_disk. */
+#define INODE_INLINE 0x1                /* 데이터가 inode 안에 있음 / Data is inline. */
+#define INODE_DIR 0x2                   /* 디렉토리 / Directory. */
+
+/* 파일 끝에서 자랄 때 미리 할당하는 섹터 수의 범위 */
+/* Bounds on the number of sectors preallocated when a file grows
+ * at its end. */
+#define PREALLOC_MIN 8
+#define PREALLOC_MAX 128
+
+/* 할당되지 않은 섹터 */
+/* No sector allocated. */
+#define NO_SECTOR ((disk_sector_t) -1)
+
+/* 익스텐트. 파일의 섹터 [LOGICAL, LOGICAL + LENGTH)가
+ * 디스크의 섹터 [START, START + LENGTH)에 있습니다. */
+/* An extent: sectors [LOGICAL, LOGICAL + LENGTH) of a file are
+ * stored in disk sectors [START, START + LENGTH). */
+struct extent {
+	uint32_t logical;                   /* 파일 안의 첫 섹터. */
+	/* First sector within the file. */
+	disk_sector_t start;                /* 디스크의 첫 섹터. */
+	/* First sector on disk. */
+	uint32_t length;                    /* 섹터 수. */
+	/* Number of sectors. */
+};
+
+/* 해제를 미룬 디스크 섹터 [START, START + LENGTH). */
+/* Disk sectors [START, START + LENGTH) whose release is
+ * deferred. */
+struct sector_run {
+	disk_sector_t start;                /* 첫 섹터. */
+	/* First sector. */
+	uint32_t length;                    /* 섹터 수. */
+	/* Number of sectors. */
+};
+
 /* 디스크 상의 inode.
  * 반드시 DISK_SECTOR_SIZE 바이트 길이여야 합니다. */
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
-	disk_sector_t start;                /* 첫 번째 데이터 섹터. */
-	/* First data sector. */
 	off_t length;                       /* 파일 크기 (바이트 단위). */
 	/* File size in bytes. */
 	unsigned magic;                     /* 매직 넘버. */
 	/* Magic number. */
-	uint32_t unused[125];               /* 사용되지 않음. */
-	/* Not used. */
+	uint32_t extent_cnt;                /* 전체 익스텐트 수. */
+	/* Total number of extents. */
+	disk_sector_t overflow;             /* 첫 넘침 블록, 없으면 0. */
+	/* First overflow block, or 0 if none. */
+	uint32_t flags;                     /* INODE_INLINE, INODE_DIR. */
+	union {
+		struct extent extents[INODE_EXTENTS]; /* 앞쪽 익스텐트들. */
+		/* First extents, sorted by LOGICAL. */
+		uint8_t inline_data[INODE_INLINE_MAX]; /* INODE_INLINE이면 파일 데이터. */
+		/* File data, if INODE_INLINE. */
+	};
+};
+
+/* inode 섹터 안에서 인라인 데이터의 오프셋 */
+/* Offset of the inline data within the inode sector. */
+#define INLINE_OFS offsetof (struct inode_disk, inline_data)
+
+/* 넘침 블록. inode에 들어가지 않는 익스텐트를 담으며 사슬로 이어집니다. */
+/* Overflow block, holding the extents that do not fit in the
+ * inode.  Overflow blocks form a chain. */
+struct extent_block {
+	disk_sector_t next;                 /* 다음 넘침 블록, 없으면 0. */
+	/* Next overflow block, or 0 if none. */
+	uint32_t unused;
+	struct extent extents[BLOCK_EXTENTS];
 };
 
 /* SIZE 바이트 길이의 inode를 할당하기 위해 필요한 섹터 수를 반환합니다. */
@@ -37,57 +111,455 @@ bytes_to_sectors (off_t size) {
 /* 메모리 상의 inode. */
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* inode 리스트의 요소. */
-	/* Element in inode list. */
+	struct list_elem elem;              /* inode 해시 버킷의 요소. */
+	/* Element in an inode hash bucket. */
+	struct list_elem closed_elem;       /* 닫힌 inode 리스트의 요소. */
+	/* Element in closed_inodes while OPEN_CNT is 0. */
 	disk_sector_t sector;               /* 디스크 위치의 섹터 번호. */
 	/* Sector number of disk location. */
 	int open_cnt;                       /* 열려 있는 개수. */
 	/* Number of openers. */
 	bool removed;                       /* 삭제되었으면 true, 그렇지 않으면 false. */
 	/* True if deleted, false otherwise. */
+	bool journaled;                     /* 내용이 메타데이터이면 true. */
+	/* True if the contents are metadata, written through the journal. */
 	int deny_write_cnt;                 /* 0: 쓰기 가능, >0: 쓰기 금지. */
 	/* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* inode 내용. */
 	/* Inode content. */
+	struct extent *extents;             /* 모든 익스텐트, LOGICAL 순. */
+	/* All DATA.EXTENT_CNT extents, sorted by LOGICAL. */
+	size_t extent_cap;                  /* EXTENTS의 크기. */
+	/* Capacity of EXTENTS. */
+	disk_sector_t *blocks;              /* 넘침 블록들의 섹터, 사슬 순. */
+	/* Sectors of the overflow blocks, in chain order. */
+	size_t block_cnt;                   /* 넘침 블록 수. */
+	/* Number of overflow blocks. */
+	uint32_t init_end;                  /* 이 앞의 할당된 섹터는 모두 초기화됨. */
+	/* Allocated file sectors below this one all hold written data
+	   or zeros.  Allocated sectors at or past it were preallocated
+	   and never written, and may hold anything. */
+	struct rwlock rw;                   /* 위의 익스텐트, 길이, 플래그, 쓰기 금지를 보호. */
+	/* Protects the extents, the length, the flags and
+	   DENY_WRITE_CNT.  Held shared to look them up and exclusively
+	   to change them. */
+	unsigned seq;                       /* RW를 배타적으로 잡은 동안 홀수. */
+	/* Odd while RW is held exclusively, see inode_translate. */
+	int copy_cnt;                       /* 잠금 없이 진행 중인 복사 수. */
+	/* Copies to or from a sector of INODE that are in progress
+	   without the lock, see inode_translate.  Changed only with
+	   interrupts off. */
+	struct sector_run *deferred;        /* 복사가 끝나면 해제할 섹터들. */
+	/* Sectors punched out while copies were in progress, released
+	   once COPY_CNT drops to 0. */
+	size_t deferred_cnt;                /* DEFERRED의 원소 수. */
+	/* Number of runs in DEFERRED. */
+	size_t deferred_cap;                /* DEFERRED의 크기. */
+	/* Capacity of DEFERRED. */
+	bool loading;                       /* 디스크에서 읽는 중이면 true. */
+	/* True while inode_open reads the inode from disk.  Protected
+	   by inodes_lock. */
+	struct lock dir_lock;               /* 디렉토리 계층이 쓰는 잠금. */
+	/* Lock for the directory layer, see inode_dir_lock. */
 };
 
+static bool inode_store (struct inode *);
+static void inode_free (struct inode *);
+static void inode_truncate (struct inode *, uint32_t keep);
+static bool inode_uninline (struct inode *, uint8_t *scratch);
+
+/* INODE의 데이터가 inode 섹터 안에 있으면 true를 반환합니다. */
+/* Returns true if INODE's data is inline in its inode sector. */
+static inline bool
+inode_is_inline (const struct inode *inode) {
+	return inode->data.flags & INODE_INLINE;
+}
+
+/* INODE에서 LOGICAL 섹터 이하에서 시작하는 마지막 익스텐트의 인덱스를 반환합니다.
+ * 그런 익스텐트가 없으면 -1을 반환합니다. */
+/* Returns the index of the last extent of INODE that starts at or
+ * before file sector LOGICAL, or -1 if there is none. */
+static int
+extent_floor (const struct inode *inode, uint32_t logical) {
+	int lo = 0, hi = (int) inode->data.extent_cnt - 1, found = -1;
+
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (inode->extents[mid].logical <= logical) {
+			found = mid;
+			lo = mid + 1;
+		} else
+			hi = mid - 1;
+	}
+	return found;
+}
+
 /* INODE 내에서 POS 바이트 오프셋을 포함하는 디스크 섹터를 반환합니다.
- * INODE에 해당 오프셋의 데이터가 없으면 -1을 반환합니다. */
+ * 해당 오프셋에 할당된 섹터가 없으면 NO_SECTOR를 반환합니다.
+ * 익스텐트 배열을 이진 탐색하므로 디스크를 읽지 않습니다. */
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
- * Returns -1 if INODE does not contain data for a byte at offset
- * POS. */
+ * Returns NO_SECTOR if no sector is allocated for POS, either
+ * because POS is past the end of the file or because it falls in
+ * a hole.  This is a binary search over the in-memory extents and
+ * never touches the disk. */
 static disk_sector_t
 byte_to_sector (const struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
+	uint32_t logical = pos / DISK_SECTOR_SIZE;
+	int i = extent_floor (inode, logical);
+
+	if (i < 0 || logical >= inode->extents[i].logical + inode->extents[i].length)
+		return NO_SECTOR;
+	return inode->extents[i].start + (logical - inode->extents[i].logical);
+}
+
+/* INODE의 익스텐트 배열을 적어도 CNT개가 들어가도록 늘립니다. */
+/* Grows the extent array of INODE to hold at least CNT extents. */
+static bool
+extent_reserve (struct inode *inode, size_t cnt) {
+	if (cnt <= inode->extent_cap)
+		return true;
+
+	size_t cap = inode->extent_cap != 0 ? inode->extent_cap * 2 : 8;
+	while (cap < cnt)
+		cap *= 2;
+
+	struct extent *extents = realloc (inode->extents, cap * sizeof *extents);
+	if (extents == NULL)
+		return false;
+	inode->extents = extents;
+	inode->extent_cap = cap;
+	return true;
+}
+
+/* 파일 섹터 LOGICAL부터 LENGTH개가 디스크 섹터 START부터 있다고 INODE에 기록합니다.
+ * 논리적으로나 물리적으로 이어지는 이웃 익스텐트가 있으면 합칩니다. */
+/* Records in INODE that LENGTH file sectors starting at LOGICAL
+ * are stored at disk sector START, merging with neighbouring
+ * extents that are contiguous both in the file and on disk. */
+static bool
+extent_add (struct inode *inode, uint32_t logical, disk_sector_t start,
+		uint32_t length) {
+	int i = extent_floor (inode, logical);
+	struct extent *prev = i >= 0 ? &inode->extents[i] : NULL;
+	struct extent *next = (uint32_t) (i + 1) < inode->data.extent_cnt
+		? &inode->extents[i + 1] : NULL;
+
+	if (prev != NULL && prev->logical + prev->length == logical
+			&& prev->start + prev->length == start) {
+		prev->length += length;
+		if (next != NULL && logical + length == next->logical
+				&& start + length == next->start) {
+			prev->length += next->length;
+			memmove (next, next + 1,
+					(inode->data.extent_cnt - (i + 2)) * sizeof *next);
+			inode->data.extent_cnt--;
+		}
+		return true;
+	}
+	if (next != NULL && logical + length == next->logical
+			&& start + length == next->start) {
+		next->logical = logical;
+		next->start = start;
+		next->length += length;
+		return true;
+	}
+
+	if (!extent_reserve (inode, inode->data.extent_cnt + 1))
+		return false;
+	struct extent *e = &inode->extents[i + 1];
+	memmove (e + 1, e, (inode->data.extent_cnt - (i + 1)) * sizeof *e);
+	e->logical = logical;
+	e->start = start;
+	e->length = length;
+	inode->data.extent_cnt++;
+	return true;
+}
+
+/* INODE의 디스크 섹터 START부터 CNT개를 해제합니다. DEFER이고 잠금 없이 진행 중인
+ * 복사가 있으면 복사가 모두 끝날 때까지 미룹니다. 그 자리는 inode_reserve_deferred로
+ * 마련해 두어야 합니다. */
+/* Releases the CNT disk sectors starting at START, which belonged
+ * to INODE.  If DEFER is true and copies are in progress without
+ * the lock, which may still be reading or writing these sectors,
+ * the release waits until they are all done; room for that must
+ * have been made with inode_reserve_deferred. */
+static void
+inode_release (struct inode *inode, disk_sector_t start, size_t cnt,
+		bool defer) {
+	if (defer && inode->copy_cnt > 0) {
+		struct sector_run *run;
+
+		ASSERT (inode->deferred_cnt < inode->deferred_cap);
+		run = &inode->deferred[inode->deferred_cnt++];
+		run->start = start;
+		run->length = cnt;
+	} else
+		free_map_release (start, cnt);
+}
+
+/* 진행 중인 복사가 있으면 INODE의 익스텐트 수만큼 해제를 미룰 자리를 마련합니다.
+ * 익스텐트를 지울 때 해제되는 구간은 익스텐트 수를 넘지 않습니다. 메모리가 부족하면
+ * false를 반환합니다. inode의 잠금을 배타적으로 잡은 채로 불러야 합니다. */
+/* Makes room to defer the release of as many runs as INODE has
+ * extents, which bounds the runs extent_remove releases, if copies
+ * are in progress.  Returns false if memory allocation fails.
+ * Must be called with INODE's lock held exclusively. */
+static bool
+inode_reserve_deferred (struct inode *inode) {
+	size_t need = inode->deferred_cnt + inode->data.extent_cnt;
+	struct sector_run *deferred;
+
+	if (inode->copy_cnt == 0 || need <= inode->deferred_cap)
+		return true;
+	deferred = realloc (inode->deferred, need * sizeof *deferred);
+	if (deferred == NULL)
+		return false;
+	inode->deferred = deferred;
+	inode->deferred_cap = need;
+	return true;
+}
+
+/* 미뤄 둔 INODE의 섹터들을 해제합니다. 진행 중인 복사가 없을 때, 저널 작업 안에서
+ * 불러야 합니다. */
+/* Releases the sectors whose release INODE deferred.  Must be
+ * called with no copies in progress, within a journal
+ * operation. */
+static void
+inode_release_deferred (struct inode *inode) {
+	ASSERT (inode->copy_cnt == 0);
+
+	while (inode->deferred_cnt > 0) {
+		struct sector_run *run = &inode->deferred[--inode->deferred_cnt];
+		free_map_release (run->start, run->length);
+	}
+}
+
+/* INODE에서 파일 섹터 [FIRST, END)에 할당된 섹터를 해제하여 구멍으로 만듭니다.
+ * 익스텐트 한가운데를 비우면 익스텐트를 둘로 나눕니다. 메모리가 부족하면 false를 반환합니다. */
+/* Releases the sectors of INODE that back file sectors [FIRST,
+ * END), leaving a hole, as inode_release does with DEFER.  An
+ * extent with the range in its middle is split in two.  Only the
+ * in-memory extents change.  Returns false if memory allocation
+ * fails. */
+static bool
+extent_remove (struct inode *inode, uint32_t first, uint32_t end,
+		bool defer) {
+	int i = extent_floor (inode, first);
+
+	if (i < 0)
+		i = 0;
+	while ((uint32_t) i < inode->data.extent_cnt) {
+		struct extent *e = &inode->extents[i];
+		uint32_t e_end = e->logical + e->length;
+		uint32_t lo = e->logical > first ? e->logical : first;
+		uint32_t hi = e_end < end ? e_end : end;
+
+		if (e->logical >= end)
+			break;
+		if (lo >= hi) {
+			i++;
+			continue;
+		}
+
+		if (lo > e->logical && hi < e_end) {
+			if (!extent_reserve (inode, inode->data.extent_cnt + 1))
+				return false;
+			e = &inode->extents[i];
+			memmove (e + 2, e + 1,
+					(inode->data.extent_cnt - (i + 1)) * sizeof *e);
+			e[1].logical = hi;
+			e[1].start = e->start + (hi - e->logical);
+			e[1].length = e_end - hi;
+			inode->data.extent_cnt++;
+		}
+
+		inode_release (inode, e->start + (lo - e->logical), hi - lo, defer);
+		if (lo == e->logical && hi == e_end) {
+			memmove (e, e + 1, (inode->data.extent_cnt - (i + 1)) * sizeof *e);
+			inode->data.extent_cnt--;
+		} else if (lo == e->logical) {
+			e->start += hi - lo;
+			e->logical = hi;
+			e->length = e_end - hi;
+		} else {
+			e->length = lo - e->logical;
+			i++;
+		}
+	}
+	return true;
+}
+
+/* INODE의 SECTOR에 BUFFER를 씁니다. 메타데이터를 담는 inode이면 저널을 거칩니다.
+ * BUFFER는 커널 메모리여야 합니다. */
+/* Writes SIZE bytes from BUFFER at byte OFS of SECTOR, which
+ * belongs to INODE, through the journal if INODE holds metadata.
+ * BUFFER must be in kernel memory. */
+static void
+inode_sector_write (struct inode *inode, disk_sector_t sector,
+		const void *buffer, size_t ofs, size_t size) {
+	if (inode->journaled)
+		journal_write (sector, buffer, ofs, size);
 	else
-		return -1;
+		page_cache_write (sector, buffer, ofs, size);
 }
 
+/* 파일 섹터 LOGICAL부터 최대 CNT개의 섹터를 할당해 INODE에 붙입니다.
+ * 뒤에 있는 익스텐트와 겹치지 않게 줄이며, 앞 익스텐트 바로 뒤의 디스크 공간을 먼저 찾습니다.
+ * 구멍을 메우는 섹터, 즉 init_end 앞의 섹터만 0으로 채웁니다. 그 뒤의 섹터는 쓰이지 않은
+ * 채로 남고, 처음 쓰일 때 inode_init_sector가 준비합니다.
+ * 할당한 섹터 수를 반환하며, 디스크가 가득 찼으면 0을 반환합니다. */
+/* Allocates up to CNT sectors for file sector LOGICAL onward and
+ * adds them to INODE.  CNT is cut short so as not to run into the
+ * next extent.  The allocator is asked for the disk space right
+ * after the preceding extent first, so files that grow stay
+ * contiguous.  Only the sectors that fill a hole below init_end
+ * are zeroed.  The ones past it, typically preallocated at end of
+ * file, are left unwritten until inode_init_sector prepares them
+ * on first write.  Returns the number of sectors allocated, or 0
+ * if the disk is full. */
+static size_t
+inode_allocate (struct inode *inode, uint32_t logical, size_t cnt) {
+	static char zeros[DISK_SECTOR_SIZE];
+	int i = extent_floor (inode, logical);
+	disk_sector_t goal = inode->sector + 1;
+	disk_sector_t start;
+
+	if (i >= 0)
+		goal = inode->extents[i].start + (logical - inode->extents[i].logical);
+	if ((uint32_t) (i + 1) < inode->data.extent_cnt
+			&& inode->extents[i + 1].logical - logical < cnt)
+		cnt = inode->extents[i + 1].logical - logical;
+
+	if (!free_map_allocate_near (goal, cnt, &start, &cnt))
+		return 0;
+	if (!extent_add (inode, logical, start, cnt)) {
+		free_map_release (start, cnt);
+		return 0;
+	}
+
+	for (size_t j = 0; j < cnt && logical + j < inode->init_end; j++)
+		inode_sector_write (inode, start + j, zeros, 0, DISK_SECTOR_SIZE);
+	return cnt;
+}
+
+/* INODE의 파일 섹터 LOGICAL (디스크 섹터 SECTOR)에 OFS 바이트부터 SIZE 바이트를 처음
+ * 쓰기 전에 준비합니다. LOGICAL은 init_end 이상이어야 합니다. 건너뛴 init_end와 LOGICAL
+ * 사이의 쓰이지 않은 섹터는 해제하여 구멍으로 만들고, 쓰기가 섹터 일부만 덮으면 섹터를 먼저
+ * 0으로 채웁니다. 익스텐트가 바뀌었으면 true를 반환하며, 그러면 호출자가 inode_store를
+ * 불러야 합니다. inode의 잠금을 잡은 채로, 저널 작업 안에서 불러야 합니다. */
+/* Prepares file sector LOGICAL of INODE, stored at disk sector
+ * SECTOR, for its first write of SIZE bytes at byte OFS.  LOGICAL
+ * must be at or past init_end.  Never-written sectors between
+ * init_end and LOGICAL are released, so that the range the write
+ * skips over reads as zeros without writing any.  If the write
+ * covers only part of the sector, the sector is zeroed first.
+ * Returns true if the extents changed, in which case the caller
+ * must call inode_store.  Must be called with INODE's lock held
+ * exclusively, within a journal operation. */
+static bool
+inode_init_sector (struct inode *inode, uint32_t logical,
+		disk_sector_t sector, int ofs, int size) {
+	static const char zeros[DISK_SECTOR_SIZE];
+	bool changed = false;
+
+	ASSERT (logical >= inode->init_end);
+
+	if (inode->init_end < logical) {
+		changed = true;
+		/* 익스텐트를 나눌 메모리가 없으면 대신 0으로 씁니다. */
+		/* Without memory to split an extent, zero the sectors
+		 * instead. */
+		if (!extent_remove (inode, inode->init_end, logical, false))
+			for (uint32_t l = inode->init_end; l < logical; l++) {
+				disk_sector_t s = byte_to_sector (inode,
+						(off_t) l * DISK_SECTOR_SIZE);
+				if (s != NO_SECTOR)
+					inode_sector_write (inode, s, zeros, 0, DISK_SECTOR_SIZE);
+			}
+	}
+	if (ofs != 0 || size != DISK_SECTOR_SIZE)
+		inode_sector_write (inode, sector, zeros, 0, DISK_SECTOR_SIZE);
+	inode->init_end = logical + 1;
+	return changed;
+}
+
+/* 파일 끝에서 자랄 때 미리 할당할 섹터 수. 파일 크기의 1/8이며 범위로 제한합니다. */
+/* Number of sectors to preallocate when INODE grows at its end:
+ * an eighth of the file, within [PREALLOC_MIN, PREALLOC_MAX]. */
+static size_t
+inode_prealloc_cnt (const struct inode *inode) {
+	size_t cnt = bytes_to_sectors (inode->data.length) / 8;
+
+	if (cnt < PREALLOC_MIN)
+		return PREALLOC_MIN;
+	return cnt < PREALLOC_MAX ? cnt : PREALLOC_MAX;
+}
+
+/* inode 해시 버킷 수, 2의 거듭제곱 */
+/* Number of inode hash buckets, a power of 2. */
+#define INODE_BUCKETS 64
+
+/* 메모리에 남겨 두는 닫힌 inode의 최대 수 */
+/* Maximum number of closed inodes kept in memory. */
+#define INODE_CLOSED_MAX 32
+
 /* 동일한 `struct inode'를 두 번 열 때 동일한 inode를 반환하기 위해
- * 열려 있는 inode의 리스트를 유지합니다. */
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+ * 메모리에 있는 inode를 섹터 번호로 해시해 둡니다. */
+/* Inodes in memory, hashed by sector, so that opening a single
+ * inode twice returns the same `struct inode'. */
+static struct list inode_buckets[INODE_BUCKETS];
+
+/* 최근에 닫힌 inode들. 가장 최근 것이 앞쪽입니다.
+ * 해시에도 남아 있으므로 다시 열 때 디스크를 읽지 않습니다. */
+/* Recently closed inodes, most recent first.  They stay in the
+ * hash as well, so reopening one needs no I/O. */
+static struct list closed_inodes;
+static size_t closed_cnt;
+
+/* 해시, 닫힌 inode 리스트, 그리고 모든 inode의 OPEN_CNT와 REMOVED를 보호합니다. */
+/* Protects the hash, the closed list, and every inode's OPEN_CNT
+ * and REMOVED. */
+static struct lock inodes_lock;
+
+/* inode_open이 inode를 다 읽었을 때 알립니다. */
+/* Signaled when inode_open finishes loading an inode. */
+static struct condition inode_loaded;
+
+/* SECTOR의 inode가 들어가는 해시 버킷 */
+/* Returns the hash bucket for the inode at SECTOR. */
+static struct list *
+inode_bucket (disk_sector_t sector) {
+	return &inode_buckets[hash_int (sector) & (INODE_BUCKETS - 1)];
+}
 
 /* inode 모듈을 초기화합니다. */
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	for (size_t i = 0; i < INODE_BUCKETS; i++)
+		list_init (&inode_buckets[i]);
+	list_init (&closed_inodes);
+	closed_cnt = 0;
+	lock_init (&inodes_lock);
+	cond_init (&inode_loaded);
 }
 
 /* LENGTH 바이트 길이의 데이터로 inode를 초기화하고
  * 새로운 inode를 파일 시스템 디스크의 SECTOR에 씁니다.
+ * INODE_INLINE_MAX 바이트 이하의 파일은 데이터를 inode 섹터 안에 담습니다. 더 큰 파일도
+ * 데이터 섹터를 할당하지 않으며, 처음 쓰일 때까지 파일 전체가 0으로 읽히는 구멍입니다.
  * 성공하면 true를 반환합니다.
- * 메모리 또는 디스크 할당에 실패하면 false를 반환합니다. */
+ * 메모리 할당에 실패하면 false를 반환합니다. */
 /* Initializes an inode with LENGTH bytes of data and
  * writes the new inode to sector SECTOR on the file system
- * disk.
+ * disk.  The data of a file up to INODE_INLINE_MAX bytes long is
+ * kept in the inode sector itself.  A larger file gets no data
+ * sectors either: it starts out as one hole that reads as zeros,
+ * and sectors are allocated as they are first written.
  * Returns true if successful.
- * Returns false if memory or disk allocation fails. */
+ * Returns false if memory allocation fails. */
 bool
 inode_create (disk_sector_t sector, off_t length) {
 	struct inode_disk *disk_inode = NULL;
@@ -100,28 +572,172 @@ inode_create (disk_sector_t sector, off_t length) {
 	/* If this assertion fails, the inode structure is not exactly
 	 * one sector in size, and you should fix that. */
 	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
+	ASSERT (sizeof (struct extent_block) == DISK_SECTOR_SIZE);
 
 	disk_inode = calloc (1, sizeof *disk_inode);
 	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
+		if (length <= (off_t) INODE_INLINE_MAX)
+			disk_inode->flags = INODE_INLINE;
+
+		/* 섹터 전체를 써서 인라인 데이터와 익스텐트 자리를 0으로 채웁니다. */
+		/* Write the whole sector, so the inline data or the
+		 * extents start out as zeros. */
+		journal_begin ();
+		journal_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
+		journal_end ();
 		free (disk_inode);
+		success = true;
 	}
 	return success;
 }
 
+/* SECTOR에 있는 inode와 넘침 블록들을 INODE로 읽어 옵니다. */
+/* Reads the inode at SECTOR and its overflow blocks into INODE. */
+static bool
+inode_load (struct inode *inode, disk_sector_t sector) {
+	size_t cnt, inline_cnt, i;
+	disk_sector_t block;
+
+	page_cache_read (sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	cnt = inode->data.extent_cnt;
+	/* 파일 끝 뒤에 남은 섹터는 충돌 전에 미리 할당되고 쓰이지 않은 것입니다. */
+	/* Any sectors past end of file were preallocated before a
+	 * crash and never written. */
+	inode->init_end = bytes_to_sectors (inode->data.length);
+	inline_cnt = cnt < INODE_EXTENTS ? cnt : INODE_EXTENTS;
+	if (!extent_reserve (inode, cnt))
+		return false;
+	memcpy (inode->extents, inode->data.extents,
+			inline_cnt * sizeof *inode->extents);
+
+	inode->block_cnt = DIV_ROUND_UP (cnt - inline_cnt, BLOCK_EXTENTS);
+	inode->blocks = malloc (inode->block_cnt * sizeof *inode->blocks);
+	if (inode->block_cnt > 0 && inode->blocks == NULL)
+		return false;
+
+	for (i = 0, block = inode->data.overflow; i < inode->block_cnt; i++) {
+		size_t first = inline_cnt + i * BLOCK_EXTENTS;
+		size_t n = cnt - first < BLOCK_EXTENTS ? cnt - first : BLOCK_EXTENTS;
+
+		inode->blocks[i] = block;
+		page_cache_read (block, &inode->extents[first],
+				offsetof (struct extent_block, extents),
+				n * sizeof (struct extent));
+		page_cache_read (block, &block, offsetof (struct extent_block, next),
+				sizeof block);
+	}
+	return true;
+}
+
+/* INODE의 내용과 익스텐트를 디스크(버퍼 캐시)에 씁니다.
+ * 필요한 만큼 넘침 블록을 할당하고 남는 블록은 해제합니다.
+ * 인라인 inode는 섹터에 있는 데이터를 덮지 않도록 머리 부분만 씁니다. */
+/* Writes INODE's on-disk data and extents to the buffer cache,
+ * allocating overflow blocks as needed and releasing the ones
+ * that are no longer needed.  They are metadata, so they go
+ * through the journal.  For an inline inode only the fields
+ * before the inline data are written, since the cached sector is
+ * where the data lives. */
+static bool
+inode_store (struct inode *inode) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t cnt = inode->data.extent_cnt;
+	size_t inline_cnt = cnt < INODE_EXTENTS ? cnt : INODE_EXTENTS;
+	size_t need = DIV_ROUND_UP (cnt - inline_cnt, BLOCK_EXTENTS);
+	size_t i;
+
+	if (inode_is_inline (inode)) {
+		journal_write (inode->sector, &inode->data, 0, INLINE_OFS);
+		return true;
+	}
+
+	if (need > inode->block_cnt) {
+		disk_sector_t *blocks = realloc (inode->blocks, need * sizeof *blocks);
+		if (blocks == NULL)
+			return false;
+		inode->blocks = blocks;
+		while (inode->block_cnt < need) {
+			if (!free_map_allocate (1, &blocks[inode->block_cnt]))
+				return false;
+			journal_write (blocks[inode->block_cnt], zeros, 0,
+					DISK_SECTOR_SIZE);
+			inode->block_cnt++;
+		}
+	}
+	while (inode->block_cnt > need)
+		free_map_release (inode->blocks[--inode->block_cnt], 1);
+
+	for (i = 0; i < need; i++) {
+		size_t first = inline_cnt + i * BLOCK_EXTENTS;
+		size_t n = cnt - first < BLOCK_EXTENTS ? cnt - first : BLOCK_EXTENTS;
+		disk_sector_t next = i + 1 < need ? inode->blocks[i + 1] : 0;
+
+		journal_write (inode->blocks[i], &next,
+				offsetof (struct extent_block, next), sizeof next);
+		journal_write (inode->blocks[i], &inode->extents[first],
+				offsetof (struct extent_block, extents),
+				n * sizeof (struct extent));
+	}
+
+	memset (inode->data.extents, 0, sizeof inode->data.extents);
+	memcpy (inode->data.extents, inode->extents,
+			inline_cnt * sizeof *inode->extents);
+	inode->data.overflow = need > 0 ? inode->blocks[0] : 0;
+	journal_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	return true;
+}
+
+/* 인라인 inode INODE의 데이터를 새로 할당한 첫 데이터 섹터로 옮깁니다. SCRATCH는
+ * INODE_INLINE_MAX 바이트 크기의 버퍼입니다. inode의 잠금을 잡은 채로, 저널 작업 안에서
+ * 불러야 합니다. 디스크가 가득 차면 false를 반환합니다. */
+/* Moves the data of inline inode INODE out to a newly allocated
+ * first data sector, so that the file can grow past
+ * INODE_INLINE_MAX.  SCRATCH is an INODE_INLINE_MAX byte buffer.
+ * Must be called with INODE's lock held exclusively, within a journal
+ * operation.  Returns false if the disk is full. */
+static bool
+inode_uninline (struct inode *inode, uint8_t *scratch) {
+	off_t length = inode->data.length;
+
+	ASSERT (inode_is_inline (inode));
+
+	if (length > 0) {
+		page_cache_read (inode->sector, scratch, INLINE_OFS, length);
+		if (inode_allocate (inode, 0, 1) == 0)
+			return false;
+		if (inode->init_end == 0)
+			inode_init_sector (inode, 0, inode->extents[0].start, 0, length);
+		inode_sector_write (inode, inode->extents[0].start, scratch, 0, length);
+	}
+	inode->data.flags &= ~INODE_INLINE;
+	return inode_store (inode);
+}
+
+/* INODE에서 파일 섹터 KEEP 이후에 할당된 섹터를 모두 해제합니다.
+ * 익스텐트 배열만 바꾸므로 필요하면 호출자가 inode_store를 불러야 합니다. */
+/* Releases every sector of INODE at file sector KEEP or beyond.
+ * Only the in-memory extents change; the caller must call
+ * inode_store if the inode stays in use. */
+static void
+inode_truncate (struct inode *inode, uint32_t keep) {
+	while (inode->data.extent_cnt > 0) {
+		struct extent *e = &inode->extents[inode->data.extent_cnt - 1];
+
+		if (e->logical + e->length <= keep)
+			break;
+		if (e->logical >= keep) {
+			free_map_release (e->start, e->length);
+			inode->data.extent_cnt--;
+		} else {
+			uint32_t cut = e->logical + e->length - keep;
+			free_map_release (e->start + e->length - cut, cut);
+			e->length -= cut;
+		}
+	}
+}
+
 /* SECTOR에서 inode를 읽어와서
  * 이를 포함하는 `struct inode'를 반환합니다.
  * 메모리 할당에 실패하면 null 포인터를 반환합니다. */
@@ -132,32 +748,72 @@ struct inode *
 inode_open (disk_sector_t sector) {
 	struct list_elem *e;
 	struct inode *inode;
+	bool success;
 
-	/* 이 inode가 이미 열려 있는지 확인합니다. */
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
+	/* 이 inode가 이미 메모리에 있는지 확인합니다.
+	 * 닫혀 있던 것이면 닫힌 inode 리스트에서 되살리고, 다른 스레드가 읽는 중이면 기다립니다. */
+	/* Check whether this inode is already in memory, reviving it
+	 * from the closed list if nobody has it open, or waiting for
+	 * it if another thread is still loading it. */
+	struct list *bucket = inode_bucket (sector);
+	lock_acquire (&inodes_lock);
+retry:
+	for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e)) {
 		inode = list_entry (e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen (inode);
+			if (inode->loading) {
+				cond_wait (&inode_loaded, &inodes_lock);
+				goto retry;
+			}
+			if (inode->open_cnt == 0) {
+				list_remove (&inode->closed_elem);
+				closed_cnt--;
+			}
+			inode->open_cnt++;
+			lock_release (&inodes_lock);
 			return inode; 
 		}
 	}
 
 	/* 메모리 할당. */
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	inode = calloc (1, sizeof *inode);
+	if (inode == NULL) {
+		lock_release (&inodes_lock);
 		return NULL;
+	}
 
-	/* 초기화. */
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* 초기화. 읽는 동안 같은 inode를 여는 스레드가 기다리도록 먼저 해시에 넣습니다. */
+	/* Initialize.  The inode goes into the hash before it is read,
+	 * marked as loading, so that a concurrent open of the same
+	 * sector waits for it instead of reading it a second time. */
+	list_push_front (bucket, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	inode->journaled = false;
+	inode->seq = 0;
+	inode->loading = true;
+	rwlock_init (&inode->rw);
+	lock_init (&inode->dir_lock);
+	lock_release (&inodes_lock);
+
+	/* 디스크 읽기는 inodes_lock 없이 합니다. */
+	/* Read the inode without holding inodes_lock. */
+	success = inode_load (inode, sector);
+
+	lock_acquire (&inodes_lock);
+	inode->loading = false;
+	if (!success)
+		list_remove (&inode->elem);
+	cond_broadcast (&inode_loaded, &inodes_lock);
+	lock_release (&inodes_lock);
+
+	if (!success) {
+		inode_free (inode);
+		return NULL;
+	}
 	return inode;
 }
 
@@ -165,8 +821,11 @@ inode_open (disk_sector_t sector) {
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&inodes_lock);
 		inode->open_cnt++;
+		lock_release (&inodes_lock);
+	}
 	return inode;
 }
 
@@ -177,12 +836,28 @@ inode_get_inumber (const struct inode *inode) {
 	return inode->sector;
 }
 
+/* INODE의 메모리를 해제합니다. */
+/* Frees the memory held by INODE. */
+static void
+inode_free (struct inode *inode) {
+	free (inode->extents);
+	free (inode->blocks);
+	free (inode->deferred);
+	free (inode); 
+}
+
 /* INODE를 닫고 디스크에 씁니다.
- * 만약 이것이 INODE에 대한 마지막 참조였다면, 메모리를 해제합니다.
- * 만약 INODE가 제거된 inode였다면, 블록을 해제합니다. */
+ * 만약 이것이 INODE에 대한 마지막 참조였고 INODE가 제거된 inode였다면,
+ * 블록과 메모리를 해제합니다.
+ * 그렇지 않으면 파일 끝 뒤에 미리 할당해 둔 섹터를 돌려주고, 다시 열릴 때를 위해
+ * 닫힌 inode 리스트에 남겨 둡니다. 리스트가 넘치면 가장 오래된 것을 해제합니다. */
 /* Closes INODE and writes it to disk.
- * If this was the last reference to INODE, frees its memory.
- * If INODE was also a removed inode, frees its blocks. */
+ * If this was the last reference to INODE and INODE was also a
+ * removed inode, frees its blocks and its memory.
+ * Otherwise gives back the sectors preallocated past its end and
+ * keeps INODE on the closed list, so a later inode_open finds it
+ * in memory.  The oldest closed inode is freed once the list
+ * holds INODE_CLOSED_MAX of them. */
 void
 inode_close (struct inode *inode) {
 	/* null 포인터를 무시합니다. */
@@ -192,21 +867,47 @@ inode_close (struct inode *inode) {
 
 	/* 마지막 오픈한 사람이었던 경우 자원을 해제합니다. */
 	/* Release resources if this was the last opener. */
+	journal_begin ();
+	lock_acquire (&inodes_lock);
 	if (--inode->open_cnt == 0) {
-		/* inode 리스트에서 제거하고 잠금을 해제합니다. */
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		inode_release_deferred (inode);
 
 		/* 제거된 경우 블록을 해제합니다. */
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
+			list_remove (&inode->elem);
+			lock_release (&inodes_lock);
+			inode_truncate (inode, 0);
+			while (inode->block_cnt > 0)
+				free_map_release (inode->blocks[--inode->block_cnt], 1);
 			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+			inode_free (inode);
+			journal_end ();
+			return;
 		}
 
-		free (inode); 
+		uint32_t keep = bytes_to_sectors (inode->data.length);
+		size_t cnt = inode->data.extent_cnt;
+
+		if (cnt > 0 && inode->extents[cnt - 1].logical
+				+ inode->extents[cnt - 1].length > keep) {
+			inode_truncate (inode, keep);
+			inode_store (inode);
+		}
+		if (inode->init_end > keep)
+			inode->init_end = keep;
+
+		list_push_front (&closed_inodes, &inode->closed_elem);
+		if (++closed_cnt > INODE_CLOSED_MAX) {
+			struct inode *old = list_entry (list_pop_back (&closed_inodes),
+					struct inode, closed_elem);
+			list_remove (&old->elem);
+			closed_cnt--;
+			inode_free (old);
+		}
 	}
+	lock_release (&inodes_lock);
+	journal_end ();
 }
 
 /* INODE가 마지막으로 열려 있는 사람이 닫을 때 삭제되도록 표시합니다. */
@@ -215,7 +916,102 @@ inode_close (struct inode *inode) {
 void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
+	lock_acquire (&inodes_lock);
 	inode->removed = true;
+	lock_release (&inodes_lock);
+}
+
+/* INODE의 잠금을 배타적으로 잡습니다. 잡고 있는 동안 SEQ는 홀수입니다. */
+/* Acquires INODE's lock exclusively.  SEQ stays odd until
+ * inode_unlock_exclusive. */
+static void
+inode_lock_exclusive (struct inode *inode) {
+	rwlock_acquire_write (&inode->rw);
+	inode->seq++;
+	barrier ();
+}
+
+/* 배타적으로 잡은 INODE의 잠금을 해제합니다. */
+/* Releases INODE's lock, held exclusively. */
+static void
+inode_unlock_exclusive (struct inode *inode) {
+	barrier ();
+	inode->seq++;
+	rwlock_release_write (&inode->rw);
+}
+
+/* INODE의 섹터로부터 또는 섹터로의 복사를 잠금 없이 시작합니다. inode의 잠금을 잡은
+ * 채로, 섹터 위치를 구한 뒤에 불러야 합니다. */
+/* Notes that a copy to or from a sector of INODE is about to run
+ * without the lock, so that inode_punch_hole does not release the
+ * sector under it.  Must be called with INODE's lock held, after
+ * looking up the sector. */
+static void
+inode_copy_begin (struct inode *inode) {
+	enum intr_level old_level = intr_disable ();
+	inode->copy_cnt++;
+	intr_set_level (old_level);
+}
+
+/* inode_copy_begin이나 inode_translate로 시작한 복사를 끝냅니다. 마지막 복사였고
+ * 해제를 미룬 섹터가 있으면 해제합니다. */
+/* Ends a copy started by inode_copy_begin or inode_translate.  If
+ * it was the last one in progress, releases the sectors punched
+ * out in the meantime. */
+static void
+inode_copy_done (struct inode *inode) {
+	enum intr_level old_level = intr_disable ();
+	bool release = --inode->copy_cnt == 0 && inode->deferred_cnt > 0;
+	intr_set_level (old_level);
+
+	if (release) {
+		journal_begin ();
+		inode_lock_exclusive (inode);
+		if (inode->copy_cnt == 0)
+			inode_release_deferred (inode);
+		inode_unlock_exclusive (inode);
+		journal_end ();
+	}
+}
+
+/* INODE의 OFFSET 바이트가 든 섹터를 반환하고, *LEFT에 OFFSET부터 파일 끝까지의 바이트
+ * 수를 넣습니다. IS_INLINE이 null이 아니면 인라인 여부도 넣습니다.
+ * 익스텐트를 바꾸는 스레드가 없으면 (SEQ가 짝수) 인터럽트만 끈 채 잠금 없이 찾고,
+ * 있으면 공유 잠금을 잡고 찾습니다. 섹터를 반환하면 복사를 시작한 것으로 치므로
+ * 호출자는 복사를 마친 뒤 inode_copy_done을 불러야 합니다. */
+/* Returns the sector that holds byte OFFSET of INODE, or
+ * NO_SECTOR, and stores the number of bytes from OFFSET to end of
+ * file in *LEFT, and whether the data is inline in *IS_INLINE if
+ * it is nonnull.  This is the path every cached read takes, so it
+ * does not touch RW unless it must: with interrupts off no other
+ * thread runs, and an even SEQ means no thread is halfway through
+ * changing the extents, so they can be searched as they are.  An
+ * odd SEQ falls back to waiting for the shared lock.  If a sector
+ * is returned, a copy from it counts as started, as with
+ * inode_copy_begin, and the caller must call inode_copy_done once
+ * it is done with the sector. */
+static disk_sector_t
+inode_translate (struct inode *inode, off_t offset, off_t *left,
+		bool *is_inline) {
+	disk_sector_t sector;
+	enum intr_level old_level = intr_disable ();
+	bool locked = inode->seq % 2 != 0;
+
+	if (locked) {
+		intr_set_level (old_level);
+		rwlock_acquire_read (&inode->rw);
+		old_level = intr_disable ();
+	}
+	sector = byte_to_sector (inode, offset);
+	*left = inode->data.length - offset;
+	if (is_inline != NULL)
+		*is_inline = inode_is_inline (inode);
+	if (sector != NO_SECTOR)
+		inode->copy_cnt++;
+	intr_set_level (old_level);
+	if (locked)
+		rwlock_release_read (&inode->rw);
+	return sector;
 }
 
 /* INODE의 SIZE 바이트를 OFFSET에서 시작하여 BUFFER에 읽어옵니다.
@@ -228,36 +1024,73 @@ off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
+
+	/* 인라인 데이터는 블록으로 옮겨질 수 있으므로 잠금 안에서 커널 버퍼로 먼저 복사합니다.
+	 * 디렉터리 탐색에서도 불리므로 버퍼는 커널 스택에 두지 않습니다. */
+	/* Inline data may be moved out to a block at any time, so it
+	 * is copied into a kernel buffer under the lock first.  The
+	 * buffer is malloc'd, since this is reached from directory
+	 * lookup with little kernel stack to spare. */
+	rwlock_acquire_read (&inode->rw);
+	if (inode_is_inline (inode)) {
+		uint8_t *data = NULL;
+
+		if (offset < inode->data.length) {
+			bytes_read = inode->data.length - offset;
+			if (bytes_read > size)
+				bytes_read = size;
+			data = malloc (bytes_read);
+			if (data == NULL)
+				bytes_read = 0;
+			else
+				page_cache_read (inode->sector, data, INLINE_OFS + offset,
+						bytes_read);
+		}
+		rwlock_release_read (&inode->rw);
+		if (data != NULL) {
+			memcpy (buffer, data, bytes_read);
+			free (data);
+		}
+		return bytes_read;
+	}
+	rwlock_release_read (&inode->rw);
 
 	while (size > 0) {
-		/* Disk sector to read, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
-		int sector_ofs = offset % DISK_SECTOR_SIZE;
+		/* 섹터 위치만 구하고 복사는 잠금 없이 합니다.
+		 * 열려 있는 inode에서 파일 끝 안쪽 섹터의 위치는 바뀌지 않으며, 구멍을 뚫어도
+		 * 복사가 끝날 때까지 섹터는 해제되지 않습니다. */
+		/* Only the translation is synchronized; the copy is not,
+		 * since the caller's buffer may fault.  While the inode is
+		 * open, a sector below end of file never moves, and one
+		 * punched out is not released until the copy is done. */
+		/* Disk sector to read, bytes left in inode. */
+		off_t inode_left;
+		disk_sector_t sector_idx = inode_translate (inode, offset,
+				&inode_left, NULL);
 
-		/* Bytes left in inode, bytes left in sector, lesser of the two. */
-		off_t inode_left = inode_length (inode) - offset;
+		/* Starting byte offset within sector, bytes left in sector,
+		 * lesser of the two. */
+		int sector_ofs = offset % DISK_SECTOR_SIZE;
 		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
 		int min_left = inode_left < sector_left ? inode_left : sector_left;
 
 		/* Number of bytes to actually copy out of this sector. */
 		int chunk_size = size < min_left ? size : min_left;
-		if (chunk_size <= 0)
+		if (chunk_size <= 0) {
+			if (sector_idx != NO_SECTOR)
+				inode_copy_done (inode);
 			break;
+		}
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+		/* 할당되지 않은 섹터는 0으로 읽힙니다. 나머지는 버퍼 캐시에서 바로 복사합니다. */
+		/* Sectors never written read as zeros.  Otherwise copy
+		 * straight from the buffer cache into caller's buffer. */
+		if (sector_idx == NO_SECTOR)
+			memset (buffer + bytes_read, 0, chunk_size);
+		else {
+			page_cache_read (sector_idx, buffer + bytes_read, sector_ofs,
+					chunk_size);
+			inode_copy_done (inode);
 		}
 
 		/* Advance. */
@@ -265,84 +1098,339 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
 
 	return bytes_read;
 }
+/* INODE의 OFFSET부터 SIZE 바이트를 SINK에 넘깁니다. 데이터는 버퍼 캐시에서 복사 없이
+ * 바로 넘기며, 구멍은 0으로 넘깁니다. SINK가 덜 받으면 멈춥니다.
+ * 넘긴 바이트 수를 반환합니다. */
+/* Hands SIZE bytes of INODE starting at OFFSET to SINK, straight
+ * from the buffer cache without copying them out first.  Holes
+ * are handed on as zeros.  Stops at end of file or when SINK takes
+ * fewer bytes than it was given.  Returns the number of bytes
+ * SINK took. */
+off_t
+inode_transfer (struct inode *inode, off_t size, off_t offset,
+		inode_sink_func *sink, void *aux) {
+	static const char zeros[DISK_SECTOR_SIZE];
+	off_t bytes_sent = 0;
+
+	while (size > 0) {
+		bool is_inline;
+		off_t inode_left;
+		disk_sector_t sector_idx = inode_translate (inode, offset,
+				&inode_left, &is_inline);
+
+		/* 인라인 데이터는 옮겨질 수 있으므로 inode_read_at으로 복사해서 넘깁니다. */
+		/* Inline data may move, so it is copied out with
+		 * inode_read_at instead.  An inline inode has no
+		 * extents, so no copy was started. */
+		if (is_inline) {
+			off_t n = size < inode_left ? size : inode_left;
+			uint8_t *data = n > 0 ? malloc (n) : NULL;
+
+			if (data != NULL) {
+				n = inode_read_at (inode, data, n, offset);
+				bytes_sent += sink (aux, data, n);
+				free (data);
+			}
+			break;
+		}
+
+		int sector_ofs = offset % DISK_SECTOR_SIZE;
+		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
+		int min_left = inode_left < sector_left ? inode_left : sector_left;
+		int chunk_size = size < min_left ? size : min_left;
+		off_t taken;
+
+		if (chunk_size <= 0) {
+			if (sector_idx != NO_SECTOR)
+				inode_copy_done (inode);
+			break;
+		}
+		if (sector_idx == NO_SECTOR)
+			taken = sink (aux, zeros, chunk_size);
+		else {
+			const uint8_t *data = page_cache_pin (sector_idx);
+			taken = sink (aux, data + sector_ofs, chunk_size);
+			page_cache_unpin (sector_idx);
+			inode_copy_done (inode);
+		}
+
+		bytes_sent += taken;
+		if (taken < chunk_size)
+			break;
+		size -= chunk_size;
+		offset += chunk_size;
+	}
+	return bytes_sent;
+}
+
+/* INODE의 OFFSET부터 SIZE 바이트를 버퍼 캐시로 미리 읽도록 요청합니다.
+ * 읽기를 기다리지 않고 바로 돌아옵니다. */
+/* Asks the buffer cache to read ahead SIZE bytes of INODE starting
+ * at OFFSET, without waiting for the reads. */
+void
+inode_readahead (struct inode *inode, off_t offset, off_t size) {
+	off_t end = offset + size;
+
+	rwlock_acquire_read (&inode->rw);
+	if (end > inode_length (inode))
+		end = inode_length (inode);
+
+	for (; offset < end; offset += DISK_SECTOR_SIZE - offset % DISK_SECTOR_SIZE) {
+		disk_sector_t sector = byte_to_sector (inode, offset);
+		if (sector != NO_SECTOR)
+			page_cache_prefetch (sector);
+	}
+	rwlock_release_read (&inode->rw);
+}
+
 /* SIZE 바이트를 BUFFER로부터 INODE의 OFFSET 위치에 씁니다.
- * 실제로 쓰인 바이트 수를 반환합니다. 파일 끝에 도달하거나
- * 오류가 발생하면 SIZE보다 적을 수 있습니다.
- * (보통 파일 끝에 쓸 경우 inode가 확장되지만, 확장은 아직 구현되지 않았습니다.) */
+ * 실제로 쓰인 바이트 수를 반환합니다. 디스크가 가득 차면 SIZE보다 적을 수 있습니다.
+ * 파일 끝 너머에 쓰면 파일이 자랍니다. 섹터는 처음 쓰일 때 할당되므로
+ * 건너뛴 부분은 할당되지 않고 0으로 읽히며, 파일 끝에서 자랄 때는 뒤쪽 섹터를 미리 할당합니다. */
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the disk fills up.
+ * A write past end of file extends the inode.  Sectors are only
+ * allocated when first written, so a region skipped over by such
+ * a write takes no space and reads as zeros.  When the file grows
+ * at its end, some sectors beyond the write are preallocated so
+ * that the file stays contiguous; inode_close gives back the ones
+ * left unused. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	rwlock_acquire_read (&inode->rw);
+	bool denied = inode->deny_write_cnt > 0;
+	rwlock_release_read (&inode->rw);
+	if (denied)
 		return 0;
 
+	/* 인라인 파일에 대한 쓰기. 들어가면 inode 섹터에 쓰고, 넘치면 먼저 데이터를 블록으로
+	 * 옮깁니다. 호출자의 버퍼는 폴트가 날 수 있으므로 잠그기 전에 malloc한 버퍼로 복사해 둡니다. */
+	/* Writes to an inline file go into the inode sector if they
+	 * fit.  Otherwise the data is moved out to a block first.  The
+	 * caller's buffer may fault, so it is copied into a malloc'd
+	 * buffer before locking. */
+	if (inode_is_inline (inode) && size > 0) {
+		uint8_t *data = malloc (INODE_INLINE_MAX);
+		bool fits = offset + size <= (off_t) INODE_INLINE_MAX;
+		bool done = false;
+
+		if (data == NULL)
+			return 0;
+		if (fits)
+			memcpy (data, buffer, size);
+		journal_begin ();
+		inode_lock_exclusive (inode);
+		if (inode_is_inline (inode)) {
+			if (fits) {
+				journal_write (inode->sector, data, INLINE_OFS + offset, size);
+				if (offset + size > inode->data.length) {
+					inode->data.length = offset + size;
+					inode_store (inode);
+				}
+				done = true;
+			} else if (!inode_uninline (inode, data)) {
+				inode_unlock_exclusive (inode);
+				journal_end ();
+				free (data);
+				return 0;
+			}
+		}
+		inode_unlock_exclusive (inode);
+		journal_end ();
+		free (data);
+		if (done)
+			return size;
+	}
+
 	while (size > 0) {
+		/* 읽기와 마찬가지로 섹터 위치를 구하고 할당하는 동안만 잠급니다. 이미 쓰인 섹터를
+		 * 덮어쓸 때는 공유 잠금으로 충분하고, 할당하거나 준비할 때만 배타적으로 잡습니다. */
+		/* As in inode_read_at, the lock covers finding or allocating
+		 * the sector but not the copy.  Overwriting a sector that
+		 * already holds data needs the lock only shared; it is taken
+		 * exclusively just to allocate or prepare a sector. */
+		journal_begin ();
+		rwlock_acquire_read (&inode->rw);
 		/* 쓸 섹터, 섹터 내의 시작 바이트 오프셋. */
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
-		/* inode에 남은 바이트, 섹터에 남은 바이트, 두 값 중 더 작은 값. */
-		/* Bytes left in inode, bytes left in sector, lesser of the two. */
-		off_t inode_left = inode_length (inode) - offset;
-		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
-		int min_left = inode_left < sector_left ? inode_left : sector_left;
-
 		/* 실제로 이 섹터에 쓸 바이트 수. */
 		/* Number of bytes to actually write into this sector. */
-		int chunk_size = size < min_left ? size : min_left;
-		if (chunk_size <= 0)
-			break;
+		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
+		int chunk_size = size < sector_left ? size : sector_left;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* 전체 섹터를 디스크에 직접 씁니다. */
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* 임시 버퍼가 필요합니다. */
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
+		uint32_t logical = offset / DISK_SECTOR_SIZE;
+		bool exclusive = sector_idx == NO_SECTOR || logical >= inode->init_end;
+		bool store = false;
+
+		/* 배타적으로 다시 잡는 사이에 다른 쓰기가 할당했을 수 있으므로 다시 찾습니다. */
+		/* Another writer may allocate the sector while the lock is
+		 * dropped, so look it up again. */
+		if (exclusive) {
+			rwlock_release_read (&inode->rw);
+			inode_lock_exclusive (inode);
+			sector_idx = byte_to_sector (inode, offset);
+		}
+
+		/* 처음 쓰는 섹터라면 이번 쓰기가 덮는 만큼 할당합니다. */
+		/* Allocate sectors for the rest of this write on its first
+		 * touch of an unallocated sector. */
+		if (sector_idx == NO_SECTOR) {
+			size_t cnt = bytes_to_sectors (offset + size) - logical;
+
+			if (offset + size > inode_length (inode)
+					&& cnt < inode_prealloc_cnt (inode))
+				cnt = inode_prealloc_cnt (inode);
+			if (inode_allocate (inode, logical, cnt) == 0) {
+				inode_unlock_exclusive (inode);
+				journal_end ();
+				/* 커밋을 기다리는 해제된 섹터가 있으면 커밋하고 다시 해 봅니다. */
+				/* Sectors released but not yet committed may be all
+				 * that is left; commit them and try again. */
+				if (journal_reclaim ())
+					continue;
+				break;
 			}
+			sector_idx = byte_to_sector (inode, offset);
 
-			/* 섹터에 우리가 쓰려는 부분 외에도 데이터가 있으면,
-			   먼저 섹터를 읽어와야 합니다. 그렇지 않으면,
-			   모두 0으로 된 섹터로 시작합니다. */
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
+			store = true;
+		}
+
+		/* 미리 할당되고 아직 쓰이지 않은 섹터는 처음 쓸 때 준비합니다. */
+		/* A preallocated sector is prepared on its first write. */
+		if (logical >= inode->init_end
+				&& inode_init_sector (inode, logical, sector_idx, sector_ofs,
+					chunk_size))
+			store = true;
+
+		/* 할당과 익스텐트 기록이 같은 트랜잭션에 들어가야
+		   충돌 뒤에 섹터가 새지 않습니다. */
+		/* Record the new extents in the same transaction as the
+		   allocation, so that a crash cannot leak the sectors. */
+		if (store)
+			inode_store (inode);
+		inode_copy_begin (inode);
+		if (exclusive)
+			inode_unlock_exclusive (inode);
+		else
+			rwlock_release_read (&inode->rw);
+
+		/* 버퍼 캐시에 씁니다. 디스크에는 캐시가 나중에 씁니다.
+		   섹터 일부만 쓰면 캐시가 나머지를 먼저 읽어 옵니다.
+		   메타데이터는 저널을 거칩니다. 파일 데이터는 사용자 메모리에서 올 수 있으므로
+		   작업을 끝낸 뒤에 씁니다. */
+		/* Write into the buffer cache, which writes the sector back
+		   later.  For a partial sector the cache reads in the rest
+		   of the sector first.  Metadata goes through the journal.
+		   File data may come from user memory that faults, so it is
+		   copied after the journal operation ends. */
+		if (inode->journaled) {
+			journal_write (sector_idx, buffer + bytes_written, sector_ofs,
+					chunk_size);
+			journal_end ();
+		} else {
+			journal_end ();
+			page_cache_write (sector_idx, buffer + bytes_written, sector_ofs,
+					chunk_size);
 		}
+		inode_copy_done (inode);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
+
+	/* 데이터를 다 쓴 뒤에 길이를 늘려야 읽는 쪽이 쓰레기를 보지 않습니다. */
+	/* The length grows only after the data is in place, so readers
+	 * never see bytes that are not written yet. */
+	if (bytes_written > 0 && offset > inode_length (inode)) {
+		journal_begin ();
+		inode_lock_exclusive (inode);
+		if (offset > inode->data.length) {
+			inode->data.length = offset;
+			inode_store (inode);
+		}
+		inode_unlock_exclusive (inode);
+		journal_end ();
+	}
 
 	return bytes_written;
 }
 
+/* INODE의 OFFSET부터 SIZE 바이트를 0으로 만들고, 그 안에 온전히 들어가는 섹터를 해제하여
+ * 구멍으로 만듭니다. 파일 길이는 바뀌지 않으며, 파일 끝 너머는 무시합니다.
+ * 쓰기가 금지되어 있거나 메모리가 부족하면 false를 반환합니다.
+ * 같은 범위를 동시에 읽는 쪽은 이전 데이터를 볼 수 있으며,
+ * 아직 복사 중인 섹터는 복사가 끝난 뒤에 해제합니다. */
+/* Punches a hole in INODE: the SIZE bytes starting at OFFSET read
+ * as zeros afterward, and the sectors that lie wholly inside the
+ * range are released.  Parts of sectors at the edges are zeroed
+ * in place.  The length of the file does not change, and the part
+ * of the range past end of file is ignored; the sector holding
+ * end of file counts as wholly inside if the range reaches end of
+ * file.  Returns false if writes to INODE are denied or memory
+ * allocation fails.  A read of the same range racing with the
+ * punch may still see the old data.  Sectors that a read or write
+ * racing with the punch is still copying are released only once
+ * that copy is done. */
+bool
+inode_punch_hole (struct inode *inode, off_t offset, off_t size) {
+	static const char zeros[DISK_SECTOR_SIZE];
+	bool success = true;
+
+	ASSERT (offset >= 0 && size >= 0);
+
+	journal_begin ();
+	inode_lock_exclusive (inode);
+	off_t length = inode->data.length;
+	off_t end = size < length - offset ? offset + size : length;
+
+	if (inode->deny_write_cnt > 0)
+		success = false;
+	else if (offset < end && inode_is_inline (inode))
+		journal_write (inode->sector, zeros, INLINE_OFS + offset, end - offset);
+	else if (offset < end) {
+		uint32_t first = DIV_ROUND_UP (offset, DISK_SECTOR_SIZE);
+		uint32_t last = end == length ? bytes_to_sectors (end)
+			: (size_t) end / DISK_SECTOR_SIZE;
+		off_t first_ofs = (off_t) first * DISK_SECTOR_SIZE;
+		off_t last_ofs = (off_t) last * DISK_SECTOR_SIZE;
+		disk_sector_t sector;
+
+		/* 범위 양 끝에 걸친 섹터는 걸친 부분만 0으로 씁니다. */
+		/* Zero the parts of the sectors that the range only
+		 * partly covers. */
+		if (offset < first_ofs
+				&& (sector = byte_to_sector (inode, offset)) != NO_SECTOR)
+			inode_sector_write (inode, sector, zeros,
+					offset % DISK_SECTOR_SIZE,
+					(first_ofs < end ? first_ofs : end) - offset);
+		if (last_ofs < end && last >= first
+				&& (sector = byte_to_sector (inode, last_ofs)) != NO_SECTOR)
+			inode_sector_write (inode, sector, zeros, 0, end - last_ofs);
+
+		if (first < last) {
+			success = inode_reserve_deferred (inode)
+				&& extent_remove (inode, first, last, true);
+			inode_store (inode);
+		}
+	}
+	inode_unlock_exclusive (inode);
+	journal_end ();
+	return success;
+}
+
 /* INODE에 대한 쓰기를 비활성화합니다.
  * inode를 여는 사람당 최대 한 번만 호출할 수 있습니다. */
 /* Disables writes to INODE.
@@ -350,8 +1438,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 void
 inode_deny_write (struct inode *inode) 
 {
+	inode_lock_exclusive (inode);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	inode_unlock_exclusive (inode);
 }
 
 /* INODE에 대한 쓰기를 다시 활성화합니다.
@@ -362,9 +1452,37 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	inode_lock_exclusive (inode);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	inode_unlock_exclusive (inode);
+}
+
+/* INODE의 내용을 메타데이터로 표시하여 이후의 쓰기가 저널을 거치게 합니다. */
+/* Marks INODE's contents as metadata, so that writes to it from
+ * now on go through the journal. */
+void
+inode_set_journaled (struct inode *inode) {
+	inode->journaled = true;
+}
+
+/* INODE를 디렉토리로 표시하고 디스크에 기록합니다. 저널 작업 안에서 불러야 합니다. */
+/* Marks INODE as a directory and records that on disk.  Must be
+ * called inside a journal handle. */
+void
+inode_mark_dir (struct inode *inode) {
+	inode_lock_exclusive (inode);
+	inode->data.flags |= INODE_DIR;
+	inode_store (inode);
+	inode_unlock_exclusive (inode);
+}
+
+/* INODE가 디렉토리이면 true를 반환합니다. */
+/* Returns true if INODE is a directory. */
+bool
+inode_is_dir (const struct inode *inode) {
+	return inode->data.flags & INODE_DIR;
 }
 
 /* INODE의 데이터 길이를 바이트 단위로 반환합니다. */
@@ -373,3 +1491,21 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* 디렉토리 INODE의 항목을 바꾸는 동안 잡는 잠금을 획득합니다.
+ * 디렉토리 계층이 조회와 수정을 한 번에 하도록 쓰며, inode 내부 잠금과는 별개입니다. */
+/* Acquires the directory lock of INODE.  The directory layer
+ * holds it across a lookup and the update that depends on it.
+ * It is separate from the lock inode_read_at and inode_write_at
+ * take internally. */
+void
+inode_dir_lock (struct inode *inode) {
+	lock_acquire (&inode->dir_lock);
+}
+
+/* INODE의 디렉토리 잠금을 해제합니다. */
+/* Releases the directory lock of INODE. */
+void
+inode_dir_unlock (struct inode *inode) {
+	lock_release (&inode->dir_lock);
+}
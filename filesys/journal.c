@@ -0,0 +1,684 @@
+/* journal.c: 메타데이터 선기록(write-ahead) 저널의 구현. */
+/* journal.c: Implementation of the metadata write-ahead journal.
+ *
+ * Changes to file system metadata -- inodes, extent blocks,
+ * directory blocks and the free map -- are grouped into
+ * transactions.  Code that changes metadata runs between
+ * journal_begin and journal_end, and writes metadata sectors with
+ * journal_write, which writes them into the buffer cache and
+ * holds them there: the cache does not write a held sector back.
+ *
+ * Operations join the running transaction until it commits, which
+ * the page cache worker does once a second, and journal_begin does
+ * early once the transaction holds too much of the cache.  Each
+ * operation reserves OP_BLOCKS cache blocks when it starts, and
+ * journal_write charges the blocks it actually holds against that
+ * reservation.  A
+ * commit waits for the operations in progress to finish and keeps
+ * new ones out, writes the free map's changes, and writes every
+ * held sector to the log in one sequential run followed by a
+ * commit record.  Only then are the sectors released to be
+ * written back home.  Many creates and removes thus cost a single
+ * log write, and after a crash each transaction is either wholly
+ * in the log or not at all.
+ *
+ * Sectors released during a transaction stay allocated until it
+ * commits, so that nothing can reuse them while the change that
+ * freed them could still be lost in a crash.  A released sector
+ * may also have an older copy in the log as metadata.  The commit
+ * then writes a revoke record for it, and replay skips the copies
+ * logged up to that transaction, so that they cannot overwrite
+ * file data the sector holds by then.
+ *
+ * The log fills up from its start.  A checkpoint writes every
+ * dirty cache block home and then empties the log by rewriting the
+ * journal header, whose sequence number tells which transactions
+ * in the log are current.  journal_open replays the committed
+ * transactions it finds.
+ *
+ * Only metadata goes through the journal.  File data is written
+ * back by the cache as before, so after a crash a file may show
+ * stale data, but the file system structure is consistent. */
+
+#include "filesys/journal.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <hash.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "filesys/free-map.h"
+#include "filesys/page_cache.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* 저널 헤더, 기술자 블록, 취소 블록, 커밋 블록을 식별합니다. */
+/* Identify the journal header, descriptor, revoke and commit
+ * blocks. */
+#define JOURNAL_MAGIC 0x4a524e4c
+#define DESC_MAGIC 0x4a445343
+#define REVOKE_MAGIC 0x4a52564b
+#define COMMIT_MAGIC 0x4a434d54
+
+/* 로그의 첫 섹터 */
+/* First sector of the log. */
+#define LOG_START (JOURNAL_SECTOR + 1)
+
+/* 기술자 블록 하나에 적는 섹터 번호 수 */
+/* Home sectors listed in one descriptor block. */
+#define DESC_SECTORS 125
+
+/* 트랜잭션이 잡아 둘 수 있는 캐시 블록 수, 캐시의 절반 */
+/* Cache blocks a transaction may hold: half of the cache. */
+#define MAX_HELD_BLOCKS (CACHE_SIZE / 2)
+
+/* 트랜잭션 하나의 최대 섹터 수. 잡힌 섹터는 캐시에 남으므로 캐시 전체를 넘을 수 없습니다. */
+/* Most sectors in one transaction.  Held sectors stay cached, so
+ * a transaction can never have more than the whole cache. */
+#define MAX_TXN_SECTORS (CACHE_SIZE * SECTORS_PER_PAGE)
+
+/* 작업 하나가 시작할 때 잡아 두는 캐시 블록 수 */
+/* Cache blocks reserved for one operation when it starts. */
+#define OP_BLOCKS 3
+
+/* 로그에 있는 섹터 수보다 많이 취소할 일은 없습니다. */
+/* Most sectors one transaction may revoke.  Only sectors in the
+ * log are revoked, and each only once until it is logged again. */
+#define MAX_REVOKES JOURNAL_LOG_SECTORS
+
+/* 로그를 쓸 때 모아 쓰는 버퍼의 페이지 수 */
+/* Pages in the buffer that log writes are gathered in. */
+#define STAGE_PAGES 4
+#define STAGE_SECTORS (STAGE_PAGES * PGSIZE / DISK_SECTOR_SIZE)
+
+/* 디스크 상의 저널 헤더. JOURNAL_SECTOR에 있습니다. */
+/* On-disk journal header, at JOURNAL_SECTOR. */
+struct journal_header {
+	uint32_t magic;                     /* JOURNAL_MAGIC. */
+	uint32_t seq;                       /* 로그 처음에 올 트랜잭션 번호 / Sequence number expected at the log's start. */
+	uint8_t unused[DISK_SECTOR_SIZE - 8];
+};
+
+/* 기술자 블록. 뒤따르는 CNT개 섹터가 어느 섹터의 내용인지 적습니다.
+ * 취소 블록도 같은 모양이며, 다시 적용하지 말아야 할 CNT개 섹터를 적습니다. */
+/* Descriptor block: names the home sectors of the CNT log
+ * sectors that follow it.  A revoke block has the same layout and
+ * names CNT sectors whose earlier logged copies must not be
+ * replayed; no log sectors follow it. */
+struct journal_desc {
+	uint32_t magic;                     /* DESC_MAGIC or REVOKE_MAGIC. */
+	uint32_t seq;                       /* 트랜잭션 번호 / Transaction sequence number. */
+	uint32_t cnt;                       /* 섹터 수 / Number of sectors. */
+	disk_sector_t sectors[DESC_SECTORS];
+};
+
+/* 커밋 블록. 트랜잭션의 마지막 섹터입니다. */
+/* Commit block, the last sector of a transaction. */
+struct journal_commit {
+	uint32_t magic;                     /* COMMIT_MAGIC. */
+	uint32_t seq;                       /* 트랜잭션 번호 / Transaction sequence number. */
+	uint32_t cnt;                       /* 전체 섹터 수 / Total number of sectors. */
+	uint32_t unused0;
+	uint64_t checksum;                  /* 섹터 내용의 해시 / Hash of the sectors' contents. */
+	uint8_t unused[DISK_SECTOR_SIZE - 24];
+};
+
+static bool enabled;                    /* 저널을 쓰는 중 / Journaling is on. */
+static struct journal_header header;    /* 디스크의 헤더 / Header as on disk. */
+static uint32_t seq;                    /* 다음에 커밋할 트랜잭션 번호 / Sequence number of the next commit. */
+static size_t log_head;                 /* 다음에 쓸 로그 위치 / Next free log sector, relative to LOG_START. */
+static uint8_t *stage;                  /* 로그 쓰기 버퍼 / Log write buffer. */
+
+/* 실행 중인 트랜잭션. journal_lock으로 보호됩니다. */
+/* The running transaction, protected by journal_lock. */
+static disk_sector_t txn_sectors[MAX_TXN_SECTORS]; /* 잡아 둔 섹터들 / Held sectors. */
+static size_t txn_cnt;
+static size_t held_blocks;              /* 잡아 둔 캐시 블록 수 / Cache blocks held. */
+static size_t reserved_blocks;          /* 작업들이 아직 쓰지 않은 몫 / Reserved by operations, not yet held. */
+static int active_cnt;                  /* 진행 중인 작업 수 / Operations in progress. */
+static bool committing;                 /* 커밋 또는 체크포인트 중 / A commit or checkpoint is running. */
+static struct lock journal_lock;
+static struct condition journal_cond;   /* 위의 상태가 바뀜 / The state above changed. */
+static struct bitmap *freed;            /* 커밋 때 해제할 섹터 / Sectors to release at commit. */
+static struct bitmap *logged;           /* 로그에 사본이 있는 섹터 / Sectors with a copy in the log. */
+
+/* 커밋 중인 트랜잭션이 취소하는 섹터. 커밋하는 스레드만 씁니다. */
+/* Sectors revoked by the transaction being committed.  Only used
+ * by the committing thread. */
+static disk_sector_t revokes[MAX_REVOKES];
+static size_t revoke_cnt;
+
+/* 다시 적용할 때 모은 취소 기록. */
+/* Revoke records gathered for replay. */
+struct revoke_record {
+	disk_sector_t sector;               /* 취소된 섹터 / Revoked sector. */
+	uint32_t seq;                       /* 마지막으로 취소한 트랜잭션 / Latest transaction revoking it. */
+};
+static struct revoke_record *records;
+static size_t record_cnt;
+
+static void commit (bool checkpoint);
+static size_t log_size (size_t cnt, size_t revoked);
+
+/* 포맷할 때 빈 저널을 만듭니다. */
+/* Creates an empty journal while formatting. */
+void
+journal_create (void) {
+	static struct journal_header h;
+	static uint8_t zeros[DISK_SECTOR_SIZE];
+
+	h.magic = JOURNAL_MAGIC;
+	h.seq = 1;
+	disk_write (filesys_disk, LOG_START, zeros);
+	disk_write (filesys_disk, JOURNAL_SECTOR, &h);
+}
+
+/* SEQ 트랜잭션이 SECTOR를 취소했다고 기록합니다. 자리가 없으면 false를 반환합니다. */
+/* Records that transaction SEQ revokes SECTOR.  Returns false if
+ * there is no room for another record. */
+static bool
+record_revoke (disk_sector_t sector, uint32_t seq) {
+	for (size_t i = 0; i < record_cnt; i++)
+		if (records[i].sector == sector) {
+			records[i].seq = seq;
+			return true;
+		}
+	if (record_cnt == JOURNAL_LOG_SECTORS)
+		return false;
+	records[record_cnt].sector = sector;
+	records[record_cnt++].seq = seq;
+	return true;
+}
+
+/* SEQ 트랜잭션이 로그에 적은 SECTOR의 사본을 다시 적용해야 하면 true를 반환합니다. */
+/* Returns true if the copy of SECTOR logged by transaction SEQ
+ * should be replayed, that is, if no transaction from SEQ on
+ * revoked SECTOR. */
+static bool
+replay_ok (disk_sector_t sector, uint32_t seq) {
+	for (size_t i = 0; i < record_cnt; i++)
+		if (records[i].sector == sector)
+			return records[i].seq < seq;
+	return true;
+}
+
+/* 로그에서 SEQ 트랜잭션을 찾아 검사합니다. POS에서 시작하며,
+ * 커밋까지 온전하면 트랜잭션 다음 위치를 반환하고 아니면 0을 반환합니다.
+ * RECORD이면 트랜잭션의 취소 기록을 모읍니다. BUF는 한 섹터 크기의 버퍼입니다. */
+/* Checks whether the log holds a complete transaction SEQ
+ * starting at POS.  Returns the log position just past it if so,
+ * 0 otherwise.  If RECORD is true, also gathers the transaction's
+ * revoke records.  BUF is scratch space for one sector. */
+static size_t
+scan_transaction (size_t pos, uint32_t seq, bool record, void *buf) {
+	struct journal_desc *d = buf;
+	struct journal_commit *c = buf;
+	uint64_t checksum = 0;
+	size_t start = pos, cnt = 0, revoke_blocks = 0;
+
+	while (pos < JOURNAL_LOG_SECTORS) {
+		disk_read (filesys_disk, LOG_START + pos++, buf);
+		if (d->magic == REVOKE_MAGIC && d->seq == seq
+				&& d->cnt <= DESC_SECTORS) {
+			checksum = checksum * 31 + hash_bytes (buf, DISK_SECTOR_SIZE);
+			revoke_blocks++;
+			continue;
+		}
+		if (d->magic == DESC_MAGIC && d->seq == seq && d->cnt > 0
+				&& d->cnt <= DESC_SECTORS
+				&& pos + d->cnt < JOURNAL_LOG_SECTORS) {
+			size_t n = d->cnt;
+
+			for (size_t i = 0; i < n; i++) {
+				disk_read (filesys_disk, LOG_START + pos++, buf);
+				checksum = checksum * 31 + hash_bytes (buf, DISK_SECTOR_SIZE);
+			}
+			cnt += n;
+			continue;
+		}
+		if (c->magic != COMMIT_MAGIC || c->seq != seq || c->cnt != cnt
+				|| c->checksum != checksum || cnt + revoke_blocks == 0)
+			break;
+
+		/* 커밋된 것이 확인된 뒤에야 취소 블록을 믿습니다. 취소 블록은 맨 앞에 있습니다. */
+		/* Only trust the revoke blocks, which come first, once the
+		 * transaction is known to be committed. */
+		for (; record; start++) {
+			disk_read (filesys_disk, LOG_START + start, buf);
+			if (d->magic != REVOKE_MAGIC)
+				break;
+			for (size_t i = 0; i < d->cnt; i++)
+				if (!record_revoke (d->sectors[i], seq))
+					return 0;
+		}
+		return pos;
+	}
+	return 0;
+}
+
+/* 로그의 [POS, END) 구간에 있는 SEQ 트랜잭션을 캐시를 거쳐 제자리에 씁니다.
+ * 취소된 섹터는 건너뜁니다. */
+/* Writes transaction SEQ, in log sectors [POS, END), to its home
+ * sectors through the cache, skipping revoked sectors. */
+static void
+replay_transaction (size_t pos, size_t end, uint32_t seq, void *buf) {
+	static struct journal_desc d;
+
+	while (pos < end - 1) {
+		disk_read (filesys_disk, LOG_START + pos++, &d);
+		if (d.magic == REVOKE_MAGIC)
+			continue;
+		for (size_t i = 0; i < d.cnt; i++, pos++)
+			if (replay_ok (d.sectors[i], seq)) {
+				disk_read (filesys_disk, LOG_START + pos, buf);
+				page_cache_write (d.sectors[i], buf, 0, DISK_SECTOR_SIZE);
+			}
+	}
+}
+
+/* 저널을 열고 커밋된 트랜잭션을 모두 다시 적용합니다. 프리 맵을 열기 전에 불러야 합니다.
+ * 저널이 없는 디스크면 저널을 쓰지 않습니다. */
+/* Opens the journal and replays every committed transaction in
+ * the log.  Must be called before the free map is opened.  If the
+ * disk has no journal, journaling stays off. */
+void
+journal_open (void) {
+	size_t replayed = 0, pos = 0;
+	size_t cnt = 0;
+
+	lock_init (&journal_lock);
+	cond_init (&journal_cond);
+
+	disk_read (filesys_disk, JOURNAL_SECTOR, &header);
+	if (header.magic != JOURNAL_MAGIC) {
+		printf ("journal: no journal found, journaling disabled\n");
+		return;
+	}
+
+	/* 가장 큰 트랜잭션도 빈 로그에는 들어가야 합니다. */
+	/* The largest transaction must fit in an empty log. */
+	ASSERT (log_size (MAX_TXN_SECTORS, MAX_REVOKES) <= JOURNAL_LOG_SECTORS);
+	stage = palloc_get_multiple (PAL_ASSERT, STAGE_PAGES);
+	freed = bitmap_create (disk_size (filesys_disk));
+	logged = bitmap_create (disk_size (filesys_disk));
+	records = palloc_get_page (PAL_ASSERT);
+	if (freed == NULL || logged == NULL)
+		PANIC ("journal: bitmap creation failed");
+	ASSERT (JOURNAL_LOG_SECTORS * sizeof *records <= PGSIZE);
+
+	/* 취소 기록은 뒤의 트랜잭션에도 있을 수 있으므로 먼저 커밋된 트랜잭션을 모두 훑어
+	 * 모은 뒤에 다시 적용합니다. */
+	/* A revoke may come in any later transaction, so every
+	 * committed transaction is scanned for revokes before any of
+	 * them is replayed. */
+	seq = header.seq;
+	while ((pos = scan_transaction (pos, seq + cnt, true, stage)) != 0)
+		cnt++;
+
+	/* 다시 적용한 내용이 제자리에 닿은 뒤에야 로그를 비울 수 있습니다. */
+	/* The log may only be emptied once the replayed sectors are
+	 * home. */
+	for (pos = 0; replayed < cnt; replayed++) {
+		size_t end = scan_transaction (pos, seq, false, stage);
+		replay_transaction (pos, end, seq, stage);
+		pos = end;
+		seq++;
+	}
+	palloc_free_page (records);
+	records = NULL;
+	record_cnt = 0;
+	if (replayed > 0) {
+		page_cache_flush ();
+		printf ("journal: replayed %zu transaction(s)\n", replayed);
+	}
+	header.seq = seq;
+	disk_write (filesys_disk, JOURNAL_SECTOR, &header);
+	log_head = 0;
+	enabled = true;
+}
+
+/* 실행 중인 트랜잭션을 커밋하고 체크포인트한 뒤 저널을 끕니다.
+ * filesys_crash이면 체크포인트하지 않습니다. */
+/* Commits the running transaction, checkpoints, and turns
+ * journaling off.  Skips the checkpoint if filesys_crash is
+ * set. */
+void
+journal_close (void) {
+	if (!enabled)
+		return;
+	commit (!filesys_crash);
+	enabled = false;
+}
+
+/* 메타데이터를 바꾸는 작업을 시작합니다. 파일 시스템 잠금을 잡기 전에 불러야 하며,
+ * 중첩할 수 있습니다. 커밋 중이거나 트랜잭션이 캐시를 너무 많이 잡고 있으면 기다리거나
+ * 직접 커밋합니다. */
+/* Starts an operation that changes metadata.  Must be called
+ * before acquiring any file system lock, and may nest.  Waits
+ * while a commit is running, and commits the running transaction
+ * first if it holds too much of the cache. */
+void
+journal_begin (void) {
+	struct thread *t = thread_current ();
+
+	if (!enabled || t->journal_depth++ > 0)
+		return;
+
+	lock_acquire (&journal_lock);
+	for (;;) {
+		if (!committing
+				&& held_blocks + reserved_blocks + OP_BLOCKS <= MAX_HELD_BLOCKS)
+			break;
+		if (!committing && active_cnt == 0) {
+			lock_release (&journal_lock);
+			t->journal_depth--;
+			commit (false);
+			t->journal_depth++;
+			lock_acquire (&journal_lock);
+		} else
+			cond_wait (&journal_cond, &journal_lock);
+	}
+	active_cnt++;
+	reserved_blocks += OP_BLOCKS;
+	t->journal_held = 0;
+	lock_release (&journal_lock);
+}
+
+/* journal_begin으로 시작한 작업을 끝냅니다. */
+/* Ends an operation started by journal_begin. */
+void
+journal_end (void) {
+	struct thread *t = thread_current ();
+
+	if (!enabled)
+		return;
+	ASSERT (t->journal_depth > 0);
+	if (--t->journal_depth > 0)
+		return;
+
+	/* 쓰지 않은 몫을 돌려줍니다. */
+	/* Give back the part of the reservation left unused. */
+	lock_acquire (&journal_lock);
+	if (t->journal_held < OP_BLOCKS)
+		reserved_blocks -= OP_BLOCKS - t->journal_held;
+	active_cnt--;
+	cond_broadcast (&journal_cond, &journal_lock);
+	lock_release (&journal_lock);
+}
+
+/* 메타데이터 SECTOR의 OFS 바이트부터 BUFFER의 SIZE 바이트를 씁니다.
+ * 섹터는 트랜잭션이 커밋될 때까지 캐시에 잡혀 있습니다. 작업 안에서 불러야 합니다. */
+/* Writes SIZE bytes from BUFFER at byte OFS of metadata sector
+ * SECTOR, through the cache, and adds the sector to the running
+ * transaction, which holds it in the cache until it commits.
+ * Must be called within an operation.  A newly held cache block
+ * is charged to the operation's reservation.  An operation that
+ * holds more than OP_BLOCKS is charged for the excess as well, so
+ * that new operations wait, but the cache must never fill up
+ * with held blocks. */
+void
+journal_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size) {
+	if (enabled) {
+		struct thread *t = thread_current ();
+		bool new_block;
+
+		ASSERT (t->journal_depth > 0);
+		if (page_cache_hold (sector, &new_block)) {
+			lock_acquire (&journal_lock);
+			ASSERT (txn_cnt < MAX_TXN_SECTORS);
+			txn_sectors[txn_cnt++] = sector;
+			bitmap_mark (logged, sector);
+			if (new_block) {
+				held_blocks++;
+				if (!committing && t->journal_held++ < OP_BLOCKS)
+					reserved_blocks--;
+				ASSERT (held_blocks + reserved_blocks < CACHE_SIZE);
+			}
+			lock_release (&journal_lock);
+		}
+	}
+	page_cache_write (sector, buffer, ofs, size);
+}
+
+/* SECTOR부터 CNT개 섹터의 해제를 실행 중인 트랜잭션이 커밋될 때까지 미룹니다.
+ * 저널을 쓰지 않으면 false를 반환하며, 그러면 호출자가 바로 해제합니다. */
+/* Defers the release of CNT sectors starting at SECTOR until the
+ * running transaction commits, and returns true.  Returns false
+ * if journaling is off, in which case the caller releases them at
+ * once.  Must be called within an operation. */
+bool
+journal_release (disk_sector_t sector, size_t cnt) {
+	if (!enabled)
+		return false;
+
+	ASSERT (thread_current ()->journal_depth > 0);
+	lock_acquire (&journal_lock);
+	bitmap_set_multiple (freed, sector, cnt, true);
+	lock_release (&journal_lock);
+	return true;
+}
+
+/* 실행 중인 트랜잭션이 해제한 섹터가 있으면 커밋해서 다시 할당할 수 있게 하고 true를
+ * 반환합니다. 작업 안에서는 아무것도 하지 않고 false를 반환합니다. */
+/* If the running transaction released any sectors, commits it so
+ * that they can be allocated again, and returns true.  Called
+ * after an allocation fails.  Returns false, doing nothing,
+ * within an operation or if there is nothing to gain. */
+bool
+journal_reclaim (void) {
+	bool pending;
+
+	if (!enabled || thread_current ()->journal_depth > 0)
+		return false;
+	lock_acquire (&journal_lock);
+	pending = bitmap_contains (freed, 0, bitmap_size (freed), true);
+	lock_release (&journal_lock);
+	if (pending)
+		commit (false);
+	return pending;
+}
+
+/* 실행 중인 트랜잭션을 커밋하고, 캐시의 더러운 블록을 모두 제자리에 쓴 뒤 로그를 비웁니다.
+ * 저널을 쓰지 않으면 프리 맵과 캐시만 씁니다. filesys_crash이면 커밋만 합니다. */
+/* Commits the running transaction, writes every dirty cache block
+ * home and empties the log.  Without a journal, just writes the
+ * free map and the cache back.  If filesys_crash is set, only
+ * commits, so that the log is left for the next boot to
+ * replay. */
+void
+journal_checkpoint (void) {
+	if (enabled)
+		commit (!filesys_crash);
+	else {
+		free_map_sync ();
+		page_cache_flush ();
+	}
+}
+
+/* 로그에서 CNT개 섹터를 적고 REVOKED개 섹터를 취소하는 트랜잭션이 차지하는 섹터 수 */
+/* Log sectors taken by a transaction of CNT sectors that revokes
+ * REVOKED sectors. */
+static size_t
+log_size (size_t cnt, size_t revoked) {
+	return DIV_ROUND_UP (revoked, DESC_SECTORS)
+		+ DIV_ROUND_UP (cnt, DESC_SECTORS) + cnt + 1;
+}
+
+/* 모아 둔 STAGED개 섹터를 로그의 POS 위치에 씁니다. */
+/* Writes the STAGED sectors gathered in the stage to log
+ * position POS. */
+static void
+stage_flush (size_t pos, size_t staged) {
+	if (staged > 0)
+		disk_write_multiple (filesys_disk, LOG_START + pos, staged, stage);
+}
+
+/* 실행 중인 트랜잭션을 로그에 쓰고 섹터들을 놓아 줍니다. 커밋 중에만 부릅니다. */
+/* Writes the running transaction to the log and releases its
+ * sectors.  Only called while committing. */
+static void
+write_transaction (void) {
+	struct journal_commit *c;
+	size_t pos = log_head, staged = 0;
+	uint64_t checksum = 0;
+
+	ASSERT (log_head + log_size (txn_cnt, revoke_cnt) <= JOURNAL_LOG_SECTORS);
+
+	/* 취소 블록이 앞에 옵니다. */
+	/* Revoke blocks come first. */
+	for (size_t i = 0; i < revoke_cnt; i += DESC_SECTORS) {
+		size_t n = revoke_cnt - i < DESC_SECTORS ? revoke_cnt - i : DESC_SECTORS;
+		struct journal_desc *d;
+
+		if (staged == STAGE_SECTORS) {
+			stage_flush (pos, staged);
+			pos += staged;
+			staged = 0;
+		}
+		d = (struct journal_desc *) (stage + staged++ * DISK_SECTOR_SIZE);
+		memset (d, 0, sizeof *d);
+		d->magic = REVOKE_MAGIC;
+		d->seq = seq;
+		d->cnt = n;
+		memcpy (d->sectors, &revokes[i], n * sizeof *d->sectors);
+		checksum = checksum * 31 + hash_bytes (d, DISK_SECTOR_SIZE);
+	}
+
+	for (size_t i = 0; i < txn_cnt; i += DESC_SECTORS) {
+		size_t n = txn_cnt - i < DESC_SECTORS ? txn_cnt - i : DESC_SECTORS;
+
+		for (size_t j = 0; j <= n; j++) {
+			void *slot;
+
+			if (staged == STAGE_SECTORS) {
+				stage_flush (pos, staged);
+				pos += staged;
+				staged = 0;
+			}
+			slot = stage + staged++ * DISK_SECTOR_SIZE;
+
+			if (j == 0) {
+				struct journal_desc *d = slot;
+
+				memset (d, 0, sizeof *d);
+				d->magic = DESC_MAGIC;
+				d->seq = seq;
+				d->cnt = n;
+				memcpy (d->sectors, &txn_sectors[i], n * sizeof *d->sectors);
+			} else {
+				page_cache_read (txn_sectors[i + j - 1], slot, 0,
+						DISK_SECTOR_SIZE);
+				checksum = checksum * 31 + hash_bytes (slot, DISK_SECTOR_SIZE);
+			}
+		}
+	}
+
+	/* 커밋 블록은 나머지가 모두 로그에 닿은 뒤에 씁니다. */
+	/* The commit block goes out only once the rest is in the
+	 * log. */
+	stage_flush (pos, staged);
+	pos += staged;
+	c = (struct journal_commit *) stage;
+	memset (c, 0, sizeof *c);
+	c->magic = COMMIT_MAGIC;
+	c->seq = seq;
+	c->cnt = txn_cnt;
+	c->checksum = checksum;
+	stage_flush (pos, 1);
+
+	for (size_t i = 0; i < txn_cnt; i++)
+		page_cache_unhold (txn_sectors[i]);
+	log_head = pos + 1;
+	txn_cnt = 0;
+	revoke_cnt = 0;
+	held_blocks = 0;
+	seq++;
+}
+
+/* 실행 중인 트랜잭션이 해제한 섹터들을 프리 맵에 돌려주고, 그중 로그에 사본이 있는 것은
+ * 취소할 섹터로 모읍니다. 커밋 중에만 부르므로 커밋이 끝나기 전에는 다시 할당되지 않습니다. */
+/* Gives the sectors released by the running transaction back to
+ * the free map, and collects the ones with a copy in the log to be
+ * revoked.  Only called while committing, so no operation can
+ * allocate them before the transaction is in the log. */
+static void
+release_freed (void) {
+	size_t start = 0, end;
+
+	while ((start = bitmap_scan (freed, start, 1, true)) != BITMAP_ERROR) {
+		end = bitmap_scan (freed, start, 1, false);
+		if (end == BITMAP_ERROR)
+			end = bitmap_size (freed);
+		for (size_t s = start; s < end; s++)
+			if (bitmap_test (logged, s)) {
+				ASSERT (revoke_cnt < MAX_REVOKES);
+				revokes[revoke_cnt++] = s;
+				bitmap_reset (logged, s);
+			}
+		bitmap_set_multiple (freed, start, end - start, false);
+		free_map_release_now (start, end - start);
+		start = end;
+	}
+}
+
+/* 더러운 캐시 블록을 모두 제자리에 쓰고 로그를 비웁니다. 커밋 중에, 잡힌 섹터가 없을 때만
+ * 부릅니다. */
+/* Writes every dirty cache block home and empties the log.  Only
+ * called while committing, with no sectors held. */
+static void
+empty_log (void) {
+	page_cache_flush ();
+	if (log_head > 0) {
+		header.seq = seq;
+		disk_write (filesys_disk, JOURNAL_SECTOR, &header);
+		log_head = 0;
+		bitmap_set_all (logged, false);
+	}
+}
+
+/* 진행 중인 작업이 끝나기를 기다려 실행 중인 트랜잭션을 커밋합니다. 그동안 새 작업은
+ * 기다립니다. CHECKPOINT이거나 로그에 트랜잭션 하나가 더 들어갈 자리가 없으면 로그를
+ * 비웁니다. 작업 안에서 부르면 안 됩니다. */
+/* Waits for the operations in progress to end, keeping new ones
+ * waiting, and commits the running transaction.  Then empties the
+ * log if CHECKPOINT is true or if another transaction might not
+ * fit.  Must not be called within an operation. */
+static void
+commit (bool checkpoint) {
+	struct thread *t = thread_current ();
+
+	ASSERT (t->journal_depth == 0);
+
+	lock_acquire (&journal_lock);
+	while (committing)
+		cond_wait (&journal_cond, &journal_lock);
+	committing = true;
+	while (active_cnt > 0)
+		cond_wait (&journal_cond, &journal_lock);
+	ASSERT (reserved_blocks == 0);
+	lock_release (&journal_lock);
+
+	/* 해제한 섹터와 프리 맵의 변경을 같은 트랜잭션에 넣습니다. 커밋하는 스레드는 작업 안에
+	 * 있는 것으로 칩니다. */
+	/* Put the released sectors and the rest of the free map's
+	 * changes in the same transaction.  The committing thread
+	 * counts as being in an operation for that. */
+	t->journal_depth++;
+	release_freed ();
+	free_map_sync ();
+	t->journal_depth--;
+
+	if (txn_cnt > 0 || revoke_cnt > 0)
+		write_transaction ();
+	if (checkpoint || log_head + log_size (MAX_TXN_SECTORS, MAX_REVOKES)
+			> JOURNAL_LOG_SECTORS)
+		empty_log ();
+
+	lock_acquire (&journal_lock);
+	committing = false;
+	cond_broadcast (&journal_cond, &journal_lock);
+	lock_release (&journal_lock);
+}
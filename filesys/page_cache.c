@@ -1,9 +1,80 @@
 /* page_cache.c: 페이지 캐시 (버퍼 캐시)의 구현. */
+/* page_cache.c: Implementation of the page cache (buffer cache).
+ *
+ * File system disk sectors are cached in CACHE_SIZE pages of type
+ * VM_PAGE_CACHE, eight consecutive sectors per page.  A miss
+ * reads in the whole page through swap_in, so neighbouring
+ * sectors come along for free.  Writes only dirty the cache.
+ * Dirty sectors reach the disk through swap_out, which runs when
+ * a block is evicted by the clock hand, when the worker daemon
+ * flushes periodically, and at filesys_done.
+ *
+ * Callers' buffers may be user memory that faults, and the fault
+ * may itself read a file, so data is never copied while holding
+ * cache_lock.  The block is pinned instead, which keeps the clock
+ * hand away from it until the copy is done.
+ *
+ * A write that overwrites a whole sector that is not cached does
+ * not read it first.  The sector is marked `filling' instead of
+ * valid until the copy is done, and readers of the sector wait for
+ * it on cache_io_done.
+ *
+ * Nor does any disk I/O happen under cache_lock.  swap_in and
+ * swap_out mark the sectors they transfer in the block's `io'
+ * bitmap and release the lock until the transfer is done; anyone
+ * who looks the block up meanwhile waits on cache_io_done.
+ *
+ * Read-ahead is asynchronous: page_cache_prefetch only queues the
+ * sector, and the read-ahead daemon fills the block with
+ * cache_lock released.  The block is marked `io' meanwhile, and
+ * anyone else who looks it up waits for the read to finish.  The
+ * daemon submits the reads for several queued blocks before
+ * waiting for any of them, and page_cache_flush submits every
+ * dirty run at once, so that the disk's request queue can sort
+ * and merge them.
+ *
+ * The journal holds the metadata sectors a transaction changes
+ * until it commits.  A held sector is not written back, and a
+ * block with held sectors is not evicted. */
 
 #include "vm/vm.h"
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "filesys/journal.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+/* 비어 있는 캐시 블록의 섹터 번호 */
+/* Sector number of an unused cache block. */
+#define CACHE_NO_SECTOR ((disk_sector_t) -1)
+
+/* 작업 데몬이 더러운 블록을 쓰는 주기 (틱) */
+/* How often the worker daemon writes dirty blocks back, in timer
+ * ticks. */
+#define CACHE_FLUSH_INTERVAL TIMER_FREQ
+
+/* 미리 읽기 데몬이 한 번에 읽는 최대 블록 수 */
+/* Most blocks the read-ahead daemon reads at once. */
+#define RA_BATCH (CACHE_SIZE / 4)
+
+/* 미리 읽기 요청 큐의 크기. 가득 차면 새 요청은 버립니다. */
+/* Size of the read-ahead request queue.  Requests are dropped
+ * while it is full. */
+#define RA_QUEUE_SIZE 32
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
+static void page_cache_kworkerd (void *aux);
+static void page_cache_rad (void *aux);
+static void wake_up (void *sema);
+static size_t writeback_submit (struct page *page, struct semaphore *done);
+static void writeback_wait (size_t req_cnt, struct semaphore *done);
+static struct page *cache_lookup (disk_sector_t sector, bool prefetch);
+static void cache_unpin (struct page *page);
+static void cache_wait_fill (struct page *page, int idx);
 
 /* 이 구조체는 수정하지 마십시오 */
 /* DO NOT MODIFY this struct */
@@ -16,44 +87,670 @@ static const struct page_operations page_cache_op = {
 
 tid_t page_cache_workerd;
 
+/* 블록의 모든 섹터 비트맵 */
+/* Bitmap of every sector of a block. */
+#define ALL_SECTORS ((1 << SECTORS_PER_PAGE) - 1)
+
+/* 캐시 블록들과 그 프레임 */
+/* Cache blocks and their frames. */
+static struct page cache[CACHE_SIZE];
+static struct frame cache_frames[CACHE_SIZE];
+static struct lock cache_lock;
+static struct condition cache_unpinned;     /* 고정이 풀림 / A block was unpinned. */
+static struct condition cache_io_done;      /* 입출력이 끝남 / A block's I/O finished. */
+static size_t clock_hand;
+
+/* 미리 읽기 요청 큐. cache_lock으로 보호됩니다. */
+/* Read-ahead request queue, protected by cache_lock. */
+static disk_sector_t ra_queue[RA_QUEUE_SIZE];
+static size_t ra_head, ra_cnt;
+static struct semaphore ra_pending;         /* 큐에 든 요청 수 / Queued requests. */
+
+/* 블록마다 쓰기 백 요청 자리. 블록을 io로 표시한 스레드만 씁니다. */
+/* Writeback requests, one set per block.  Used only by the thread
+ * that marked the block `io'. */
+#define WB_REQS (SECTORS_PER_PAGE / 2)
+static struct disk_request wb_reqs[CACHE_SIZE][WB_REQS];
+
+/* 통계 */
+/* Statistics. */
+static long long hit_cnt, miss_cnt, writeback_cnt, readahead_cnt;
+
+/* 캐시 블록들을 만듭니다. 파일 시스템을 읽기 전에 불러야 합니다. */
+/* Sets up the cache blocks.  Must be called before the file
+ * system is first accessed. */
+void
+page_cache_init (void) {
+	lock_init (&cache_lock);
+	cond_init (&cache_unpinned);
+	cond_init (&cache_io_done);
+	sema_init (&ra_pending, 0);
+	for (size_t i = 0; i < CACHE_SIZE; i++) {
+		void *kva = palloc_get_page (PAL_ASSERT);
+
+		cache_frames[i].kva = kva;
+		cache_frames[i].page = &cache[i];
+		cache_frames[i].thread = NULL;
+		cache[i].frame = &cache_frames[i];
+		page_cache_initializer (&cache[i], VM_PAGE_CACHE, kva);
+	}
+}
+
 /* 파일 vm의 초기화 함수 */
 /* The initializer of file vm */
 void
 pagecache_init (void) {
 	/* TODO: 페이지 캐시를 위한 워커 데몬을 page_cache_kworkerd와 함께 생성 */
 	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	page_cache_workerd = thread_create ("page_cache", PRI_MIN,
+			page_cache_kworkerd, NULL);
+	thread_create ("page_cache_ra", PRI_DEFAULT, page_cache_rad, NULL);
 }
 
 /* 페이지 캐시를 초기화합니다 */
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva UNUSED) {
 	/* 핸들러를 설정합니다 */
 	/* Set up the handler */
 	page->operations = &page_cache_op;
 
+	struct page_cache *pc = &page->page_cache;
+	pc->sector = CACHE_NO_SECTOR;
+	pc->valid = pc->dirty = pc->held = pc->filling = 0;
+	pc->filler = NULL;
+	pc->accessed = false;
+	pc->pin_cnt = 0;
+	pc->io = 0;
+	return true;
 }
 
 /* 프리페치(readhead)를 구현하기 위해 Swap in 메커니즘을 사용합니다 */
 /* Utilize the Swap in mechanism to implement readahead */
+/* 블록에서 아직 읽지 않은 섹터를 모두 읽습니다. 디스크 끝을 넘는 섹터는 0으로 채웁니다.
+ * cache_lock을 잡고 블록을 고정한 상태여야 하며, 읽는 동안에는 락을 놓습니다. */
+/* Reads every sector of the block that does not hold data yet.
+ * Sectors past the end of the disk read as zeros.  cache_lock
+ * must be held and the block pinned.  The lock is released while
+ * the sectors are read, with the sectors marked `io'. */
 static bool
 page_cache_readahead (struct page *page, void *kva) {
+	struct page_cache *pc = &page->page_cache;
+	disk_sector_t disk_end = disk_size (filesys_disk);
+	uint8_t missing;
+	int i = 0;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+	ASSERT (pc->pin_cnt > 0);
+
+	while (pc->io)
+		cond_wait (&cache_io_done, &cache_lock);
+	missing = ~(pc->valid | pc->filling) & ALL_SECTORS;
+	if (missing == 0)
+		return true;
+	pc->io = missing;
+	lock_release (&cache_lock);
+
+	/* 읽지 않은 섹터들의 연속 구간마다 명령 하나로 읽습니다. */
+	/* Each run of missing sectors is read with a single command. */
+	while (i < SECTORS_PER_PAGE) {
+		uint8_t *dst = (uint8_t *) kva + i * DISK_SECTOR_SIZE;
+		int run = 0;
+
+		if (!(missing & (1 << i))) {
+			i++;
+			continue;
+		}
+		if (pc->sector + i >= disk_end) {
+			memset (dst, 0, DISK_SECTOR_SIZE);
+			i++;
+			continue;
+		}
+		while (i + run < SECTORS_PER_PAGE && (missing & (1 << (i + run)))
+				&& pc->sector + i + run < disk_end)
+			run++;
+		disk_read_multiple (filesys_disk, pc->sector + i, run, dst);
+		i += run;
+	}
+
+	lock_acquire (&cache_lock);
+	pc->valid |= missing;
+	pc->io = 0;
+	cond_broadcast (&cache_io_done, &cache_lock);
+	return true;
 }
 
 /* 쓰기 백(writeback)을 구현하기 위해 Swap out 메커니즘을 사용합니다 */
 /* Utilize the Swap out mechanism to implement writeback */
+/* 블록의 더러운 섹터만 디스크에 씁니다. 블록은 캐시에 남습니다.
+ * cache_lock을 잡고 블록을 고정한 상태여야 하며, 쓰는 동안에는 락을 놓습니다. */
+/* Writes the dirty sectors of the block to disk.  The block stays
+ * cached.  cache_lock must be held and the block pinned.  The
+ * lock is released during the writes, with the block marked `io'
+ * so that no one changes it meanwhile. */
 static bool
 page_cache_writeback (struct page *page) {
+	struct page_cache *pc = &page->page_cache;
+	struct semaphore done;
+	size_t req_cnt;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+	ASSERT (pc->pin_cnt > 0);
+
+	while (pc->io)
+		cond_wait (&cache_io_done, &cache_lock);
+	sema_init (&done, 0);
+	req_cnt = writeback_submit (page, &done);
+	if (req_cnt == 0)
+		return true;
+	pc->io = ALL_SECTORS;
+	lock_release (&cache_lock);
+
+	writeback_wait (req_cnt, &done);
+
+	lock_acquire (&cache_lock);
+	pc->io = 0;
+	cond_broadcast (&cache_io_done, &cache_lock);
+	return true;
+}
+
+/* 디스크 요청의 완료 함수. SEMA를 올립니다. */
+/* Completion function of disk requests that ups SEMA. */
+static void
+wake_up (void *sema) {
+	sema_up (sema);
+}
+
+/* PAGE의 더러운 섹터들의 연속 구간마다 PAGE의 wb_reqs로 쓰기 요청을 하나씩
+ * 제출하고, 제출한 요청 수를 반환합니다. 요청이 끝날 때마다 DONE을 올립니다.
+ * cache_lock을 잡은 상태여야 합니다. */
+/* Submits one write request for each run of dirty sectors of
+ * PAGE, using PAGE's wb_reqs[], and returns the number of
+ * requests.  Each request ups DONE when it completes.  Held
+ * sectors stay dirty and are not written.  cache_lock must be
+ * held. */
+static size_t
+writeback_submit (struct page *page, struct semaphore *done) {
+	struct page_cache *pc = &page->page_cache;
+	struct disk_request *reqs = wb_reqs[page - cache];
+	uint8_t dirty = pc->dirty & ~pc->held;
+	size_t req_cnt = 0;
+	int i = 0;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	while (i < SECTORS_PER_PAGE) {
+		int run = 0;
+
+		while (i + run < SECTORS_PER_PAGE && (dirty & (1 << (i + run))))
+			run++;
+		if (run > 0) {
+			ASSERT (req_cnt < WB_REQS);
+			disk_request_init (&reqs[req_cnt], filesys_disk, pc->sector + i,
+					run, (uint8_t *) page->frame->kva + i * DISK_SECTOR_SIZE,
+					true, wake_up, done);
+			disk_submit (&reqs[req_cnt++]);
+			writeback_cnt += run;
+			i += run;
+		} else
+			i++;
+	}
+	pc->dirty &= pc->held;
+	return req_cnt;
+}
+
+/* writeback_submit으로 제출한 REQ_CNT개의 요청이 모두 끝나기를 기다립니다. */
+/* Waits for the REQ_CNT requests submitted by writeback_submit
+ * that up DONE. */
+static void
+writeback_wait (size_t req_cnt, struct semaphore *done) {
+	while (req_cnt-- > 0)
+		sema_down (done);
 }
 
 /* 페이지 캐시를 파괴합니다. */
 /* Destroy the page cache. */
+/* 더러운 섹터를 쓰고 블록을 비웁니다. 페이지 자체는 캐시가 계속 소유합니다.
+ * cache_lock을 잡고 블록을 고정한 상태여야 합니다. */
+/* Writes the block back and empties it.  The page itself stays
+ * owned by the cache.  cache_lock must be held and the block
+ * pinned. */
 static void
 page_cache_destroy (struct page *page) {
+	page_cache_writeback (page);
+	page->page_cache.sector = CACHE_NO_SECTOR;
+	page->page_cache.valid = 0;
 }
 
 /* 페이지 캐시를 위한 워커 스레드 */
 /* Worker thread for page cache */
+/* 주기적으로 저널의 트랜잭션을 커밋하고 더러운 블록을 씁니다. */
+/* Periodically commits the journal's running transaction and
+ * writes the dirty blocks back. */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (CACHE_FLUSH_INTERVAL);
+#ifndef EFILESYS
+		journal_checkpoint ();
+#else
+		page_cache_flush ();
+#endif
+	}
+}
+
+/* 미리 읽기 데몬. 큐에서 섹터를 꺼내 그 블록이 캐시에 없으면 읽어 옵니다.
+ * 큐에 쌓인 블록들의 읽기를 한꺼번에 제출한 뒤 기다립니다. */
+/* Read-ahead daemon.  Takes sectors off the queue and reads in
+ * their blocks if they are not cached yet.  The reads for up to
+ * RA_BATCH queued blocks are submitted together before waiting
+ * for any of them. */
+static void
+page_cache_rad (void *aux UNUSED) {
+	static struct disk_request reqs[RA_BATCH];
+	struct page *pages[RA_BATCH];
+	struct semaphore done;
+	disk_sector_t disk_end = disk_size (filesys_disk);
+
+	sema_init (&done, 0);
+	for (;;) {
+		size_t page_cnt = 0, req_cnt = 0;
+
+		sema_down (&ra_pending);
+
+		lock_acquire (&cache_lock);
+		do {
+			disk_sector_t sector = ra_queue[ra_head];
+			ra_head = (ra_head + 1) % RA_QUEUE_SIZE;
+			ra_cnt--;
+
+			struct page *page = cache_lookup (sector, true);
+			if (page != NULL) {
+				page->page_cache.io = ALL_SECTORS;
+				pages[page_cnt++] = page;
+			}
+		} while (page_cnt < RA_BATCH && sema_try_down (&ra_pending));
+		lock_release (&cache_lock);
+
+		/* 디스크를 읽는 동안에는 락을 놓아서 다른 블록의 접근을 막지 않습니다.
+		 * 새로 배정된 블록에는 유효한 섹터가 없으므로 블록 전체를 읽습니다. */
+		/* Drop the lock for the disk reads, so that hits on other
+		 * blocks go ahead meanwhile.  A newly assigned block has no
+		 * valid sectors, so the whole block is read. */
+		for (size_t i = 0; i < page_cnt; i++) {
+			struct page *page = pages[i];
+			disk_sector_t sector = page->page_cache.sector;
+			size_t cnt = SECTORS_PER_PAGE;
+
+			if (sector >= disk_end)
+				cnt = 0;
+			else if (disk_end - sector < cnt)
+				cnt = disk_end - sector;
+			memset ((uint8_t *) page->frame->kva + cnt * DISK_SECTOR_SIZE, 0,
+					(SECTORS_PER_PAGE - cnt) * DISK_SECTOR_SIZE);
+			if (cnt > 0) {
+				disk_request_init (&reqs[req_cnt], filesys_disk, sector, cnt,
+						page->frame->kva, false, wake_up, &done);
+				disk_submit (&reqs[req_cnt++]);
+			}
+		}
+		while (req_cnt-- > 0)
+			sema_down (&done);
+
+		lock_acquire (&cache_lock);
+		for (size_t i = 0; i < page_cnt; i++) {
+			pages[i]->page_cache.valid = ALL_SECTORS;
+			pages[i]->page_cache.io = 0;
+			cache_unpin (pages[i]);
+		}
+		cond_broadcast (&cache_io_done, &cache_lock);
+		lock_release (&cache_lock);
+	}
+}
+
+/* SECTOR가 든 블록을 미리 읽도록 요청하고 바로 돌아옵니다.
+ * 바로 앞 요청과 같은 블록이면 다시 넣지 않습니다. */
+/* Asks the read-ahead daemon to bring the block containing
+ * SECTOR into the cache, and returns without waiting.  Sectors in
+ * the same block as the previous request are not queued again. */
+void
+page_cache_prefetch (disk_sector_t sector) {
+	lock_acquire (&cache_lock);
+	size_t tail = (ra_head + ra_cnt + RA_QUEUE_SIZE - 1) % RA_QUEUE_SIZE;
+	bool same_block = ra_cnt > 0
+		&& ra_queue[tail] / SECTORS_PER_PAGE == sector / SECTORS_PER_PAGE;
+
+	if (!same_block && ra_cnt < RA_QUEUE_SIZE) {
+		ra_queue[(ra_head + ra_cnt) % RA_QUEUE_SIZE] = sector;
+		ra_cnt++;
+		sema_up (&ra_pending);
+	}
+	lock_release (&cache_lock);
+}
+
+/* SECTOR를 담는 블록을 찾아 고정하고 반환합니다. 없으면 클록 알고리즘으로 고정되지 않은
+ * 블록 하나를 비워서 배정합니다. 새로 배정된 블록에는 아직 데이터가 없습니다.
+ * PREFETCH이면 이미 캐시된 블록에 대해 NULL을 반환합니다.
+ * cache_lock을 잡은 상태여야 하며, 호출자는 cache_unpin을 불러야 합니다. */
+/* Returns the block that caches SECTOR, pinned.  On a miss, the
+ * clock hand picks an unpinned block that was not accessed since
+ * it last went by and reassigns it to SECTOR with no valid
+ * sectors.  A dirty block is written back first, with cache_lock
+ * released, after which the search starts over.  Waits if every
+ * block is pinned, or if the block is under I/O.  If PREFETCH is true,
+ * returns a null pointer instead when SECTOR is already cached.
+ * cache_lock must be held.  The caller must call cache_unpin. */
+static struct page *
+cache_lookup (disk_sector_t sector, bool prefetch) {
+	disk_sector_t first = sector - sector % SECTORS_PER_PAGE;
+	struct page *page;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	for (;;) {
+		struct page *dirty = NULL;
+
+		for (size_t i = 0; i < CACHE_SIZE; i++)
+			if (cache[i].page_cache.sector == first) {
+				page = &cache[i];
+				if (prefetch)
+					return NULL;
+				hit_cnt++;
+				page->page_cache.accessed = true;
+				page->page_cache.pin_cnt++;
+				while (page->page_cache.io)
+					cond_wait (&cache_io_done, &cache_lock);
+				return page;
+			}
+
+		/* 두 바퀴를 돌면 고정되지 않은 블록의 참조 비트는 모두 지워집니다. */
+		/* Two sweeps clear the reference bit of every unpinned
+		 * block, so finding nothing means all blocks are pinned. */
+		for (size_t step = 0; step < 2 * CACHE_SIZE; step++) {
+			page = &cache[clock_hand];
+			clock_hand = (clock_hand + 1) % CACHE_SIZE;
+			if (page->page_cache.pin_cnt > 0 || page->page_cache.held)
+				continue;
+			if (!page->page_cache.accessed) {
+				if (!page->page_cache.dirty)
+					goto found;
+				dirty = page;
+				break;
+			}
+			page->page_cache.accessed = false;
+		}
+
+		/* 더러운 블록은 락을 놓고 쓰므로, 그동안 SECTOR가 캐시되었을 수 있어 다시 찾습니다. */
+		/* The lock is released while a dirty block is written back,
+		 * and SECTOR may get cached meanwhile, so look it up
+		 * again afterward. */
+		if (dirty != NULL) {
+			dirty->page_cache.pin_cnt = 1;
+			swap_out (dirty);
+			cache_unpin (dirty);
+			continue;
+		}
+
+		/* 미리 읽기는 기다릴 가치가 없습니다. */
+		/* Read-ahead is not worth waiting for. */
+		if (prefetch)
+			return NULL;
+
+		/* 기다리는 동안 다른 스레드가 SECTOR를 읽어 왔을 수 있으니 다시 찾습니다. */
+		/* Another thread may cache SECTOR while we wait, so look
+		 * it up again afterward. */
+		cond_wait (&cache_unpinned, &cache_lock);
+	}
+
+found:
+	if (prefetch)
+		readahead_cnt++;
+	else
+		miss_cnt++;
+	page->page_cache.sector = first;
+	page->page_cache.valid = 0;
+	page->page_cache.accessed = true;
+	page->page_cache.pin_cnt = 1;
+	return page;
+}
+
+/* 고정한 PAGE의 IDX번째 섹터를 다른 스레드가 통째로 채우는 중이면 끝날 때까지 기다립니다.
+ * 채우는 스레드 자신은 기다리지 않습니다. 복사 중의 폴트가 같은 섹터를 읽을 수 있기 때문입니다.
+ * cache_lock을 잡은 상태여야 합니다. */
+/* Waits until no other thread is filling sector IDX of PAGE, which
+ * must be pinned, with a whole-sector write.  The filling thread
+ * itself does not wait, since a fault during its copy may read the
+ * same sector.  cache_lock must be held. */
+static void
+cache_wait_fill (struct page *page, int idx) {
+	while ((page->page_cache.filling & (1 << idx))
+			&& page->page_cache.filler != thread_current ())
+		cond_wait (&cache_io_done, &cache_lock);
+}
+
+/* cache_lookup으로 고정한 PAGE의 고정을 풉니다. cache_lock을 잡은 상태여야 합니다. */
+/* Unpins PAGE, pinned by cache_lookup.  cache_lock must be held. */
+static void
+cache_unpin (struct page *page) {
+	ASSERT (page->page_cache.pin_cnt > 0);
+	if (--page->page_cache.pin_cnt == 0)
+		cond_signal (&cache_unpinned, &cache_lock);
+}
+
+/* SECTOR를 캐시로 읽어 고정하고, 캐시 안에서 그 섹터 데이터의 주소를 반환합니다.
+ * 주소는 page_cache_unpin을 부를 때까지 유효합니다. 복사 없이 캐시의 데이터를 바로
+ * 넘길 때 씁니다. */
+/* Reads SECTOR into the cache, pins its block and returns the
+ * address of the sector's data within the cache, which stays
+ * valid until page_cache_unpin is called.  Lets callers hand the
+ * cached data on without copying it out first. */
+const void *
+page_cache_pin (disk_sector_t sector) {
+	lock_acquire (&cache_lock);
+	struct page *page = cache_lookup (sector, false);
+	int idx = sector % SECTORS_PER_PAGE;
+
+	cache_wait_fill (page, idx);
+	if (!(page->page_cache.valid & (1 << idx)))
+		swap_in (page, page->frame->kva);
+	lock_release (&cache_lock);
+	return (uint8_t *) page->frame->kva + idx * DISK_SECTOR_SIZE;
+}
+
+/* page_cache_pin으로 고정한 SECTOR의 블록의 고정을 풉니다. */
+/* Unpins the block of SECTOR, pinned by page_cache_pin. */
+void
+page_cache_unpin (disk_sector_t sector) {
+	disk_sector_t first = sector - sector % SECTORS_PER_PAGE;
+
+	lock_acquire (&cache_lock);
+	for (size_t i = 0; i < CACHE_SIZE; i++)
+		if (cache[i].page_cache.sector == first) {
+			cache_unpin (&cache[i]);
+			break;
+		}
+	lock_release (&cache_lock);
+}
+
+/* 캐시를 거쳐 SECTOR의 OFS 바이트부터 SIZE 바이트를 BUFFER로 읽습니다. */
+/* Reads SIZE bytes starting at byte OFS of SECTOR into BUFFER,
+ * through the cache. */
+void
+page_cache_read (disk_sector_t sector, void *buffer, size_t ofs,
+		size_t size) {
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	struct page *page = cache_lookup (sector, false);
+	int idx = sector % SECTORS_PER_PAGE;
+
+	cache_wait_fill (page, idx);
+	if (!(page->page_cache.valid & (1 << idx)))
+		swap_in (page, page->frame->kva);
+	lock_release (&cache_lock);
+
+	memcpy (buffer, (uint8_t *) page->frame->kva + idx * DISK_SECTOR_SIZE + ofs,
+			size);
+
+	lock_acquire (&cache_lock);
+	cache_unpin (page);
+	lock_release (&cache_lock);
+}
+
+/* 캐시를 거쳐 BUFFER의 SIZE 바이트를 SECTOR의 OFS 바이트부터 씁니다.
+ * 섹터 전체를 덮어쓰면 디스크에서 읽어 오지 않습니다. 그런 섹터는 복사가 끝날 때까지
+ * 유효하다고 표시하지 않고 `filling'으로 두어, 읽는 쪽이 이전 내용을 보지 않게 합니다. */
+/* Writes SIZE bytes from BUFFER at byte OFS of SECTOR, through the
+ * cache.  Overwriting a whole sector does not read it from disk
+ * first.  Such a sector is marked `filling' rather than valid
+ * until the copy is done, so that no reader sees what the block
+ * held before. */
+void
+page_cache_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size) {
+	bool fill = false;
+
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	struct page *page = cache_lookup (sector, false);
+	struct page_cache *pc = &page->page_cache;
+	int idx = sector % SECTORS_PER_PAGE;
+
+	cache_wait_fill (page, idx);
+	if (!(pc->valid & (1 << idx))) {
+		if (size == DISK_SECTOR_SIZE && !(pc->filling & (1 << idx))) {
+			pc->filling |= 1 << idx;
+			pc->filler = thread_current ();
+			fill = true;
+		} else
+			swap_in (page, page->frame->kva);
+	}
+	lock_release (&cache_lock);
+
+	memcpy ((uint8_t *) page->frame->kva + idx * DISK_SECTOR_SIZE + ofs, buffer,
+			size);
+
+	/* 복사가 끝난 뒤에 더럽다고 표시해야 진행 중인 플러시가 덜 쓰인 섹터만 남기지 않습니다. */
+	/* Mark the sector dirty only after the copy, so that a flush
+	 * racing with the copy cannot leave a half-written sector
+	 * marked clean. */
+	lock_acquire (&cache_lock);
+	if (fill) {
+		pc->valid |= 1 << idx;
+		pc->filling &= ~(1 << idx);
+		if (pc->filling == 0)
+			pc->filler = NULL;
+		cond_broadcast (&cache_io_done, &cache_lock);
+	}
+	pc->dirty |= 1 << idx;
+	cache_unpin (page);
+	lock_release (&cache_lock);
+}
+
+/* SECTOR를 캐시에 잡아 두어 page_cache_unhold를 부를 때까지 디스크에 쓰지 않게
+ * 합니다. 새로 잡았으면 true를 반환하고, 그 블록에서 처음 잡은 섹터이면 *FIRST_IN_BLOCK을
+ * true로 설정합니다. */
+/* Holds SECTOR in the cache: it is not written back, and its
+ * block is not evicted, until page_cache_unhold is called.
+ * Returns true if SECTOR was not held already, and sets
+ * *FIRST_IN_BLOCK to whether no other sector of its block was. */
+bool
+page_cache_hold (disk_sector_t sector, bool *first_in_block) {
+	int idx = sector % SECTORS_PER_PAGE;
+	bool newly_held;
+
+	lock_acquire (&cache_lock);
+	struct page *page = cache_lookup (sector, false);
+	struct page_cache *pc = &page->page_cache;
+
+	newly_held = !(pc->held & (1 << idx));
+	*first_in_block = pc->held == 0;
+	pc->held |= 1 << idx;
+	cache_unpin (page);
+	lock_release (&cache_lock);
+	return newly_held;
+}
+
+/* page_cache_hold로 잡아 둔 SECTOR를 놓아 줍니다. */
+/* Releases SECTOR, held by page_cache_hold. */
+void
+page_cache_unhold (disk_sector_t sector) {
+	disk_sector_t first = sector - sector % SECTORS_PER_PAGE;
+	int idx = sector % SECTORS_PER_PAGE;
+
+	lock_acquire (&cache_lock);
+	for (size_t i = 0; i < CACHE_SIZE; i++) {
+		struct page_cache *pc = &cache[i].page_cache;
+
+		if (pc->sector == first) {
+			ASSERT (pc->held & (1 << idx));
+			pc->held &= ~(1 << idx);
+			if (pc->held == 0)
+				cond_signal (&cache_unpinned, &cache_lock);
+			break;
+		}
+	}
+	lock_release (&cache_lock);
+}
+
+/* 더러운 블록을 모두 디스크에 씁니다. 모든 쓰기를 먼저 제출한 뒤, 락을 놓고 기다립니다.
+ * 다른 스레드가 입출력 중인 블록은 그 입출력이 끝난 뒤에 따로 씁니다. */
+/* Writes every dirty block back to disk.  All the writes are
+ * submitted before waiting for any of them, and the blocks are
+ * marked `io' while cache_lock is released for the wait.  Blocks
+ * already under I/O by another thread are written one by one
+ * afterward, once that I/O is done; waiting for them while
+ * holding our own `io' marks could deadlock against another
+ * flush. */
+void
+page_cache_flush (void) {
+	struct page *pages[CACHE_SIZE];
+	struct semaphore done;
+	bool busy[CACHE_SIZE];
+	size_t page_cnt = 0, req_cnt = 0;
+
+	sema_init (&done, 0);
+	lock_acquire (&cache_lock);
+	for (size_t i = 0; i < CACHE_SIZE; i++) {
+		struct page_cache *pc = &cache[i].page_cache;
+
+		busy[i] = pc->io != 0;
+		if (busy[i])
+			continue;
+		if (pc->dirty & ~pc->held) {
+			pc->pin_cnt++;
+			pc->io = ALL_SECTORS;
+			req_cnt += writeback_submit (&cache[i], &done);
+			pages[page_cnt++] = &cache[i];
+		}
+	}
+	lock_release (&cache_lock);
+
+	writeback_wait (req_cnt, &done);
+
+	lock_acquire (&cache_lock);
+	for (size_t i = 0; i < page_cnt; i++) {
+		pages[i]->page_cache.io = 0;
+		cache_unpin (pages[i]);
+	}
+	cond_broadcast (&cache_io_done, &cache_lock);
+
+	for (size_t i = 0; i < CACHE_SIZE; i++)
+		if (busy[i]) {
+			cache[i].page_cache.pin_cnt++;
+			swap_out (&cache[i]);
+			cache_unpin (&cache[i]);
+		}
+	lock_release (&cache_lock);
+}
+
+/* 캐시 통계를 출력합니다. */
+/* Prints buffer cache statistics. */
+void
+page_cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses, %lld read ahead, "
+			"%lld sectors written back\n",
+			hit_cnt, miss_cnt, readahead_cnt, writeback_cnt);
 }
@@ -2,6 +2,9 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -15,13 +18,50 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* 요청이 끝났을 때 디스크 채널의 I/O 스레드에서 불리는 함수.
+ * 디스크 I/O를 기다리는 스레드가 쥐고 있을 수 있는 락을 잡으면 안 됩니다. */
+/* Called in the disk channel's I/O thread when a request is done,
+ * or in the submitting thread for a RAM disk.
+ * It must not sleep, in particular not on a lock that a thread
+ * waiting for disk I/O might hold. */
+typedef void disk_done_func (void *aux);
+
+/* 비동기 디스크 요청. disk_request_init으로 채워서 disk_submit으로 넣습니다. */
+/* An asynchronous disk request.  Fill it in with
+ * disk_request_init and queue it with disk_submit. */
+struct disk_request {
+	struct list_elem elem;      /* Queue element. */
+	struct disk *disk;          /* Disk to transfer to or from. */
+	disk_sector_t sector;       /* First sector. */
+	size_t cnt;                 /* Number of sectors, at most 256. */
+	void *buffer;               /* Kernel buffer of CNT sectors. */
+	bool write;                 /* True to write, false to read. */
+	int64_t deadline;           /* Tick by which to serve the request. */
+	disk_done_func *done;       /* Completion function. */
+	void *aux;                  /* Passed to DONE. */
+	int pending;                /* Pieces in flight, for a virtual disk. */
+};
+
 void disk_init (void);
 void disk_print_stats (void);
 
 struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
+struct disk *disk_stripe (struct disk *members[], size_t cnt,
+		disk_sector_t unit);
+struct disk *disk_slice (struct disk *, disk_sector_t start,
+		disk_sector_t size);
+struct disk *disk_ram (disk_sector_t capacity);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_read_multiple (struct disk *, disk_sector_t, size_t cnt, void *);
+void disk_write_multiple (struct disk *, disk_sector_t, size_t cnt,
+		const void *);
+
+void disk_request_init (struct disk_request *, struct disk *,
+		disk_sector_t, size_t cnt, void *buffer, bool write,
+		disk_done_func *, void *aux);
+void disk_submit (struct disk_request *);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
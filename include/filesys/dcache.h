@@ -0,0 +1,22 @@
+#ifndef FILESYS_DCACHE_H
+#define FILESYS_DCACHE_H
+#include <stdbool.h>
+#include "devices/disk.h"
+
+/* dcache_lookup의 결과 */
+/* Result of dcache_lookup. */
+enum dcache_result {
+	DCACHE_MISS,        /* 캐시에 없음 / Not cached. */
+	DCACHE_HIT,         /* 이름이 있음 / Name exists. */
+	DCACHE_NEGATIVE,    /* 이름이 없다고 알려짐 / Name is known not to exist. */
+};
+
+void dcache_init (void);
+enum dcache_result dcache_lookup (disk_sector_t dir, const char *name,
+		disk_sector_t *sectorp);
+void dcache_add (disk_sector_t dir, const char *name, disk_sector_t sector);
+void dcache_add_negative (disk_sector_t dir, const char *name);
+void dcache_invalidate (disk_sector_t dir, const char *name);
+void dcache_purge_dir (disk_sector_t dir);
+
+#endif /* filesys/dcache.h */
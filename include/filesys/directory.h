@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "devices/disk.h"
+#include "filesys/off_t.h"
 
 /* 파일 이름 구성 요소의 최대 길이입니다.
  * 이것은 전통적인 UNIX 최대 길이입니다.
@@ -16,6 +17,7 @@
 #define NAME_MAX 14
 
 struct inode;
+struct dirent;
 
 /* 디렉터리 열기 및 닫기입니다. */
 /* Opening and closing directories. */
@@ -32,5 +34,8 @@ bool dir_lookup (const struct dir *, const char *name, struct inode **);
 bool dir_add (struct dir *, const char *name, disk_sector_t);
 bool dir_remove (struct dir *, const char *name);
 bool dir_readdir (struct dir *, char name[NAME_MAX + 1]);
+size_t dir_getdents (struct dir *, struct dirent *, size_t max);
+void dir_seek (struct dir *, off_t);
+off_t dir_tell (struct dir *);
 
 #endif /* filesys/directory.h */
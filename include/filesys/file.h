@@ -1,7 +1,9 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <stdbool.h>
 #include "filesys/off_t.h"
+#include "filesys/inode.h"
 
 struct inode;
 
@@ -15,8 +17,10 @@ struct inode *file_get_inode (struct file *);
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
+off_t file_transfer (struct file *, off_t size, inode_sink_func *, void *aux);
 off_t file_write (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+bool file_punch_hole (struct file *, off_t start, off_t size);
 
 /* 쓰기 방지 */
 /* Preventing writes. */
@@ -2,6 +2,8 @@
 #define FILESYS_FILESYS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
 #include "filesys/off_t.h"
 #include "threads/synch.h"
 
@@ -9,13 +11,24 @@
 /* Sectors of system file inodes. */
 #define FREE_MAP_SECTOR 0       /* 빈 맵 파일 아이노드 섹터 / Free map file inode sector. */
 #define ROOT_DIR_SECTOR 1       /* 루트 디렉터리 파일 아이노드 섹터 / Root directory file inode sector. */
+#define JOURNAL_SECTOR 2        /* 저널 헤더 섹터, 로그가 뒤따름 / Journal header sector, followed by the log. */
 
 /* 파일 시스템에 사용되는 디스크 */
 /* Disk used for file system. */
 extern struct disk *filesys_disk;
 
-/* 파일 시스템 락 */
-extern struct lock filesys_lock;
+/* 스트라이프 단위와 스트라이프 위의 스왑 영역 */
+/* Stripe unit, and the swap area on the stripe. */
+extern disk_sector_t filesys_stripe_unit;
+extern struct disk *filesys_swap_disk;
+
+/* 파일 시스템을 담을 RAM 디스크의 크기 (MB) */
+/* Size in MB of the RAM disk holding the file system, or 0. */
+extern size_t filesys_ram_mb;
+
+/* 종료할 때 충돌을 흉내 낼지 여부 */
+/* Simulate a crash at power off. */
+extern bool filesys_crash;
 
 void filesys_init (bool format);
 void filesys_done (void);
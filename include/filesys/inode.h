@@ -7,6 +7,12 @@
 
 struct bitmap;
 
+/* inode_transfer가 데이터를 넘기는 함수. AUX와 함께 BUFFER의 SIZE 바이트를 받고,
+ * 받아들인 바이트 수를 반환합니다. */
+/* Receives SIZE bytes at BUFFER on behalf of inode_transfer,
+ * together with AUX.  Returns the number of bytes it took. */
+typedef off_t inode_sink_func (void *aux, const void *buffer, off_t size);
+
 void inode_init (void);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
@@ -16,8 +22,17 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_transfer (struct inode *, off_t size, off_t offset,
+		inode_sink_func *, void *aux);
+void inode_readahead (struct inode *, off_t offset, off_t size);
+bool inode_punch_hole (struct inode *, off_t offset, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+void inode_set_journaled (struct inode *);
+void inode_mark_dir (struct inode *);
+bool inode_is_dir (const struct inode *);
+void inode_dir_lock (struct inode *);
+void inode_dir_unlock (struct inode *);
 
 #endif /* filesys/inode.h */
@@ -0,0 +1,24 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* 저널 로그 영역의 섹터 수. 로그는 JOURNAL_SECTOR 바로 뒤에 있습니다. */
+/* Number of sectors in the journal's log, which follows
+ * JOURNAL_SECTOR on disk. */
+#define JOURNAL_LOG_SECTORS 256
+
+void journal_create (void);
+void journal_open (void);
+void journal_close (void);
+
+void journal_begin (void);
+void journal_end (void);
+void journal_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size);
+bool journal_release (disk_sector_t sector, size_t cnt);
+bool journal_reclaim (void);
+void journal_checkpoint (void);
+
+#endif /* filesys/journal.h */
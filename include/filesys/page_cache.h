@@ -1,12 +1,49 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "devices/disk.h"
+#include "threads/vaddr.h"
 
 struct page;
 enum vm_type;
 
-struct page_cache {};
+/* 캐시 페이지 수 */
+/* Number of pages in the cache. */
+#define CACHE_SIZE 16
+
+/* 페이지 하나에 들어가는 섹터 수 */
+/* Sectors per cache page. */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+/* 캐시 블록 하나. 한 페이지에 파일 시스템 디스크의 연속된 섹터 8개를 담습니다. */
+/* One buffer cache block: a page holding eight consecutive
+ * sectors of the file system disk. */
+struct page_cache {
+	disk_sector_t sector;   /* 첫 섹터, 비어 있으면 CACHE_NO_SECTOR / First sector, or CACHE_NO_SECTOR. */
+	uint8_t valid;          /* 읽어 온 섹터 비트맵 / Bitmap of sectors holding data. */
+	uint8_t dirty;          /* 수정된 섹터 비트맵 / Bitmap of modified sectors. */
+	uint8_t held;           /* 저널이 잡아 둔 섹터 비트맵 / Bitmap of sectors held by the journal. */
+	bool accessed;          /* 클록 참조 비트 / Clock reference bit. */
+	int pin_cnt;            /* 복사 중인 스레드 수, 0보다 크면 교체 불가 / Copies in progress; pinned blocks are not evicted. */
+	uint8_t io;             /* 입출력 중인 섹터 비트맵 / Bitmap of sectors under I/O. */
+	uint8_t filling;        /* 통째로 쓰는 중인 섹터 비트맵 / Bitmap of sectors being overwritten whole. */
+	struct thread *filler;  /* FILLING을 마지막으로 설정한 스레드 / Thread that last set a FILLING bit. */
+};
 
 void page_cache_init (void);
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+void page_cache_read (disk_sector_t sector, void *buffer, size_t ofs,
+		size_t size);
+void page_cache_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size);
+const void *page_cache_pin (disk_sector_t sector);
+void page_cache_unpin (disk_sector_t sector);
+void page_cache_prefetch (disk_sector_t sector);
+bool page_cache_hold (disk_sector_t sector, bool *first_in_block);
+void page_cache_unhold (disk_sector_t sector);
+void page_cache_flush (void);
+void page_cache_print_stats (void);
 #endif
@@ -0,0 +1,27 @@
+#ifndef __LIB_DIRENT_H
+#define __LIB_DIRENT_H
+
+/* getdents가 돌려주는 디렉토리 항목 레코드.
+ * 커널과 사용자 프로그램이 함께 사용하며, 모든 레코드는 같은 크기입니다. */
+/* Directory entry record returned by getdents, shared between the
+ * kernel and user programs.  Every record has the same size. */
+
+#include <stdint.h>
+
+/* 레코드에 담기는 이름의 최대 길이. 파일 시스템의 NAME_MAX와 같습니다. */
+/* Longest name a record holds, the file system's NAME_MAX. */
+#define DIRENT_NAME_MAX 14
+
+/* D_TYPE 값 */
+/* Values of D_TYPE. */
+#define DT_REG 1            /* 일반 파일 / Regular file. */
+#define DT_DIR 2            /* 디렉토리 / Directory. */
+
+struct dirent {
+	uint32_t d_ino;                     /* inode 섹터 번호 / Inode sector number. */
+	uint32_t d_size;                    /* 바이트 단위 크기 / Size in bytes. */
+	uint8_t d_type;                     /* DT_REG 또는 DT_DIR / DT_REG or DT_DIR. */
+	char d_name[DIRENT_NAME_MAX + 1];   /* Null 문자로 끝나는 이름 / Null terminated name. */
+};
+
+#endif /* lib/dirent.h */
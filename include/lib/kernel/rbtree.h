@@ -0,0 +1,77 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* 레드-블랙 트리.
+ * 정렬된 상태를 유지하면서 삽입, 삭제, 탐색을 모두 O(log n)에 수행하는
+ * 균형 이진 탐색 트리입니다.
+ * list, hash와 마찬가지로 동적 할당을 사용하지 않습니다. 트리에 들어갈 수 있는
+ * 구조체는 반드시 struct rb_elem 멤버를 내장해야 하며, rb_entry 매크로로
+ * struct rb_elem을 이를 포함하는 구조체로 되돌릴 수 있습니다. */
+/* Red-black tree.
+ *
+ * This is a balanced binary search tree that keeps its elements
+ * in sorted order and supports insertion, deletion and lookup in
+ * O(log n) time.
+ *
+ * Like list and hash, the tree does not use dynamic allocation.
+ * Each structure that can potentially be in a tree must embed a
+ * struct rb_elem member.  The rb_entry macro allows conversion
+ * from a struct rb_elem back to a structure object that contains
+ * it.  Refer to lib/kernel/list.h for a detailed explanation of
+ * the technique. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem {
+	struct rb_elem *parent;     /* Parent, or NULL for the root. */
+	struct rb_elem *left;       /* Left child. */
+	struct rb_elem *right;      /* Right child. */
+	bool red;                   /* True if red, false if black. */
+};
+
+/* 트리 요소 RB_ELEM의 포인터를 RB_ELEM이 포함된 구조체의 포인터로 변환합니다. */
+/* Converts pointer to tree element RB_ELEM into a pointer to
+ * the structure that RB_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)                       \
+	((STRUCT *) ((uint8_t *) (RB_ELEM)                      \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two tree elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+		const struct rb_elem *b,
+		void *aux);
+
+/* Red-black tree. */
+struct rb_tree {
+	struct rb_elem *root;       /* Root element, or NULL if empty. */
+	size_t elem_cnt;            /* Number of elements in tree. */
+	rb_less_func *less;         /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+/* Basic life cycle. */
+void rb_init (struct rb_tree *, rb_less_func *, void *aux);
+
+/* Search, insertion, deletion. */
+struct rb_elem *rb_insert (struct rb_tree *, struct rb_elem *);
+void rb_delete (struct rb_tree *, struct rb_elem *);
+struct rb_elem *rb_find (struct rb_tree *, const struct rb_elem *);
+struct rb_elem *rb_floor (struct rb_tree *, const struct rb_elem *);
+struct rb_elem *rb_ceil (struct rb_tree *, const struct rb_elem *);
+
+/* In-order traversal. */
+struct rb_elem *rb_first (struct rb_tree *);
+struct rb_elem *rb_next (struct rb_elem *);
+
+/* Information. */
+size_t rb_size (struct rb_tree *);
+bool rb_empty (struct rb_tree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -36,6 +36,19 @@ enum {
 
     SYS_MOUNT,
     SYS_UMOUNT,
+
+    /* Extra for Project 3 */
+    SYS_MSYNC, /* Write back a memory mapping. */
+    SYS_VMSTAT, /* Read virtual memory statistics. */
+
+    /* Extra for Project 4 */
+    SYS_PUNCH_HOLE, /* Release a range of a file. */
+    SYS_PREAD,      /* Read from a file at a given offset. */
+    SYS_PWRITE,     /* Write to a file at a given offset. */
+    SYS_READV,      /* Read from a file into several buffers. */
+    SYS_WRITEV,     /* Write to a file from several buffers. */
+    SYS_SENDFILE,   /* Copy between files inside the kernel. */
+    SYS_GETDENTS,   /* Read many directory entries at once. */
 };
 
 #endif /* lib/syscall-nr.h */
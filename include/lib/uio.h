@@ -0,0 +1,20 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+/* 벡터 입출력에 쓰는 버퍼 목록의 항목.
+ * 커널과 사용자 프로그램이 함께 사용하며, readv와 writev가 이 구조체의 배열을 받습니다. */
+/* One buffer of a scatter/gather list, shared between the kernel
+ * and user programs.  readv and writev take an array of these. */
+
+#include <stddef.h>
+
+/* readv나 writev 한 번에 넘길 수 있는 최대 버퍼 수 */
+/* Most buffers one readv or writev call may take. */
+#define IOV_MAX 64
+
+struct iovec {
+	void *iov_base;     /* 버퍼의 시작 / Start of the buffer. */
+	size_t iov_len;     /* 버퍼의 바이트 수 / Size of the buffer in bytes. */
+};
+
+#endif /* lib/uio.h */
@@ -3,7 +3,10 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <dirent.h>
 #include <stddef.h>
+#include <uio.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -41,6 +44,8 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int vmstat (struct vm_stats *stats);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -50,6 +55,14 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+int punch_hole (int fd, off_t offset, off_t length);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int sendfile (int out_fd, int in_fd, unsigned length);
+int getdents (int fd, struct dirent *buf, unsigned size);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
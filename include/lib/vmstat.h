@@ -0,0 +1,69 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+/* 가상 메모리 계측 정보.
+ * 커널과 사용자 프로그램이 함께 사용하며, vmstat 시스템 호출이 이 구조체를 채웁니다. */
+/* Virtual memory instrumentation, shared between the kernel and
+ * user programs.  The vmstat system call fills in a struct
+ * vm_stats. */
+
+#include <stdint.h>
+
+/* 페이지 폴트의 종류 */
+/* Kinds of page fault. */
+enum vm_fault_kind {
+	VMF_STACK,          /* 스택 확장 / Stack growth. */
+	VMF_LAZY,           /* 처음 접근하는 페이지의 지연 로딩 / Lazy load on first touch. */
+	VMF_SWAP_IN,        /* 스왑 디스크에서 읽기 / Anonymous page read from swap. */
+	VMF_FILE_IN,        /* 교체된 파일 페이지 다시 읽기 / Evicted file page read again. */
+	VMF_BAD,            /* 프로세스를 종료시킨 폴트 / Fault that killed the process. */
+	VMF_CNT
+};
+
+/* 세는 사건들 */
+/* Counted events. */
+enum vm_event {
+	VME_EVICT,          /* 프레임 교체 / Frame evicted. */
+	VME_SWAP_READ,      /* 스왑 슬롯 읽기 / Page read from a swap slot. */
+	VME_SWAP_WRITE,     /* 스왑 슬롯 쓰기 / Page written to a swap slot. */
+	VME_FILE_READ,      /* 파일 페이지 읽기 / File page read from its file. */
+	VME_FILE_WRITE,     /* 파일 페이지 되돌려 쓰기 / File page written back. */
+	VME_ZERO_FILL,      /* 0으로만 채운 페이지 / Page filled with zeros only. */
+	VME_CNT
+};
+
+/* 지연 시간을 재는 구간 */
+/* Timed operations. */
+enum vm_timer {
+	VMT_CLAIM,          /* vm_do_claim_page 전체 / Whole of vm_do_claim_page. */
+	VMT_SWAP_IN,        /* swap_in / Swap in. */
+	VMT_SWAP_OUT,       /* swap_out / Swap out. */
+	VMT_UNINIT_INIT,    /* uninit_initialize / First touch of an uninit page. */
+	VMT_CNT
+};
+
+/* 히스토그램 칸 수. I번 칸은 [2^I, 2^(I+1)) 사이클을 셉니다. */
+/* Number of histogram buckets.  Bucket I counts operations that
+ * took [2^I, 2^(I+1)) TSC cycles; the last bucket also counts
+ * everything slower. */
+#define VM_HIST_BUCKETS 40
+
+struct vm_stats {
+	uint64_t faults[VMF_CNT];                   /* 종류별 폴트 수 / Faults by kind. */
+	uint64_t events[VME_CNT];                   /* 사건 수 / Event counts. */
+	uint64_t cycles[VMT_CNT];                   /* 구간별 총 사이클 / Total cycles per operation. */
+	uint64_t hist[VMT_CNT][VM_HIST_BUCKETS];    /* 구간별 지연 히스토그램 / Latency histograms. */
+
+	/* 전체 프레임 / All frames. */
+	uint64_t frames;                            /* 상주 프레임 수 / Resident frames. */
+	uint64_t global_evictions;                  /* 전역 교체 횟수 / Global evictions. */
+	uint64_t local_evictions;                   /* RSS 제한으로 인한 교체 / Evictions due to RSS limits. */
+
+	/* 호출한 프로세스 / The calling process. */
+	uint64_t rss;                               /* 상주 페이지 수 / Resident pages. */
+	uint64_t rss_peak;                          /* rss의 최댓값 / Highest rss so far. */
+	uint64_t rss_limit;                         /* RSS 제한, 0이면 없음 / RSS limit, 0 if none. */
+	uint64_t wss;                               /* 작업 집합 추정치 / Working set estimate. */
+};
+
+#endif /* lib/vmstat.h */
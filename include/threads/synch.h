@@ -46,6 +46,22 @@ void cond_wait(struct condition *, struct lock *);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast(struct condition *, struct lock *);
 
+/* Reader/writer lock. */
+struct rwlock {
+    struct lock lock;           /* Protects the fields below. */
+    struct condition readers;   /* Signaled when readers may enter. */
+    struct condition writers;   /* Signaled when a writer may enter. */
+    int active_readers;         /* Threads holding the lock shared. */
+    int waiting_writers;        /* Threads waiting to hold it exclusively. */
+    bool writing;               /* True while held exclusively. */
+};
+
+void rwlock_init(struct rwlock *);
+void rwlock_acquire_read(struct rwlock *);
+void rwlock_release_read(struct rwlock *);
+void rwlock_acquire_write(struct rwlock *);
+void rwlock_release_write(struct rwlock *);
+
 /* 최적화 바리어입니다.
  *
  * 컴파일러는 최적화 바리어를 통해 연산을 재배열하지 않습니다.
@@ -159,6 +159,14 @@ struct thread {
     /* Table for whole virtual memory owned by thread. */
     struct supplemental_page_table spt;
 #endif
+#ifdef FILESYS
+    /* 진행 중인 저널 작업의 중첩 깊이. */
+    /* Nesting depth of the journal operation in progress. */
+    int journal_depth;
+    /* 작업이 새로 잡은 캐시 블록 수. */
+    /* Cache blocks newly held by that operation. */
+    int journal_held;
+#endif
 
     /* Owned by thread.c. */
     struct intr_frame tf; /* Information for switching */
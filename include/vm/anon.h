@@ -10,5 +10,6 @@ struct anon_page {
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+bool anon_copy_contents (struct page *page, void *kva);
 
 #endif
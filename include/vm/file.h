@@ -4,6 +4,7 @@
 #include "vm/vm.h"
 
 struct page;
+struct supplemental_page_table;
 enum vm_type;
 
 struct file_page {
@@ -11,7 +12,6 @@ struct file_page {
 	off_t ofs;
 	uint32_t page_read_bytes;
 	uint32_t page_zero_bytes;
-	size_t length;
 };
 
 void vm_file_init (void);
@@ -19,4 +19,6 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+void do_msync (void *addr, size_t length);
+void do_msync_all (struct supplemental_page_table *spt);
 #endif
@@ -0,0 +1,13 @@
+#ifndef VM_STAT_H
+#define VM_STAT_H
+#include <stdint.h>
+#include <vmstat.h>
+
+void vm_stat_fault (enum vm_fault_kind kind);
+void vm_stat_event (enum vm_event event);
+uint64_t vm_stat_start (void);
+void vm_stat_stop (enum vm_timer timer, uint64_t start);
+void vm_stat_get (struct vm_stats *stats);
+void vm_stat_print (void);
+
+#endif /* VM_STAT_H */
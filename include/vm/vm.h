@@ -2,7 +2,8 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
-#include <hash.h>
+#include "threads/synch.h"
+#include <stdint.h>
 
 
 enum vm_type {
@@ -37,9 +38,8 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
-#ifdef EFILESYS
+#include "vm/vma.h"
 #include "filesys/page_cache.h"
-#endif
 
 struct page_operations;
 struct thread;
@@ -51,7 +51,6 @@ struct aux {
 	off_t ofs;
 	uint32_t read_bytes;
 	uint32_t zero_bytes;
-	size_t length;
 };
 
 /* "페이지"의 표현입니다.
@@ -67,9 +66,12 @@ struct page {
 	struct frame *frame;   /* Back reference for frame */ /* 프레임에 대한 역 참조 */
 	
 	/* Your implementation */ /* 여러분의 구현 */
-	struct hash_elem hash_elem;
 	bool is_writable;
 
+	/* 페이지가 속한 VMA와 그 VMA의 페이지 리스트 요소 */
+	struct vma *vma;
+	struct list_elem vma_elem;
+
 	/* 페이지가 중복으로 여러 곳에 저장될 수 있으므로! */
 	bool is_exist_frame;
 	bool is_exist_swap;
@@ -83,9 +85,7 @@ struct page {
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
-#ifdef EFILESYS
 		struct page_cache page_cache;
-#endif
 	};
 };
 
@@ -94,9 +94,18 @@ struct page {
 struct frame {
 	void *kva;
 	struct page *page;
+	struct thread *thread;  /* 프레임을 소유한 프로세스 */
+	bool pinned;            /* 플러셔나 fork가 쓰는 중이거나 교체 중이면 true, 교체하거나 해제하지 않음 */
+	bool referenced;        /* WSS 샘플러가 지운 접근 비트를 옮겨 둔 곳 */
 	struct list_elem elem;
 };
 
+/* 프레임 테이블과 이를 보호하는 락 */
+extern struct list frame_table;
+extern struct lock frame_lock;
+/* 고정한 프레임을 풀 때 알립니다. frame_lock과 함께 씁니다. */
+extern struct condition frames_unpinned;
+
 /* 페이지 작업을 위한 함수 테이블입니다.
  * 이것은 C에서 "인터페이스"를 구현하는 한 가지 방법입니다.
  * "메소드"의 테이블을 구조체 멤버로 넣고,
@@ -117,6 +126,12 @@ struct page_operations {
 #define destroy(page) \
 	if ((page)->operations->destroy) (page)->operations->destroy (page)
 
+/* 보조 페이지 테이블의 슬롯. PAGE가 NULL이면 빈 슬롯입니다. */
+struct spt_slot {
+	uintptr_t vpn;          /* 페이지 번호 */
+	struct page *page;
+};
+
 /* 현재 프로세스의 메모리 공간 표현입니다.
  * 이 구조체에 대해 특정한 디자인을 강요하고 싶지 않습니다.
  * 이 구조체에 대한 모든 디자인은 여러분에게 달려 있습니다. */
@@ -124,12 +139,27 @@ struct page_operations {
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-	struct hash hash_pages;
-	// todo : 보조 페이지 구조체 만들기
-	// 보조 페이지의 테이블
-
+	/* 페이지 번호를 키로 하는 개방 주소법(선형 탐사) 해시 테이블.
+	 * 슬롯에 키를 같이 두어 탐색 중에 페이지를 따라가지 않습니다. */
+	struct spt_slot *slots; /* 2의 거듭제곱 크기, 비어 있으면 NULL */
+	size_t capacity;        /* 슬롯 수 */
+	size_t page_cnt;        /* 들어 있는 페이지 수 */
+	struct page *last;      /* 마지막으로 찾은 페이지 (한 칸짜리 캐시) */
+
+	/* 시작 주소 순으로 정렬된 VMA 트리 */
+	struct rb_tree vmas;
+
+	/* 상주 집합(RSS) 통계. frame_lock으로 보호됩니다. */
+	size_t rss;             /* 프레임을 가진 페이지 수 */
+	size_t rss_peak;        /* rss의 최댓값 */
+	size_t rss_limit;       /* 넘으면 자기 페이지를 내보냄, 0이면 제한 없음 */
+	size_t wss;             /* 지난 주기 동안 접근된 페이지 수 (작업 집합 추정치) */
+	size_t wss_scan;        /* wss를 세는 동안 쓰는 임시 카운터 */
 };
 
+/* 프로세스 하나의 기본 RSS 제한 (페이지 수, 0이면 제한 없음) */
+extern size_t vm_rss_limit;
+
 
 #include "threads/thread.h"
 void supplemental_page_table_init (struct supplemental_page_table *spt);
@@ -142,6 +172,9 @@ bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
 void vm_init (void);
+void vm_print_stats (void);
+struct vm_stats;
+void vm_rss_get (struct vm_stats *stats);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -0,0 +1,63 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <list.h>
+#include <rbtree.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct page;
+struct supplemental_page_table;
+
+/* 스택이 자랄 수 있는 최대 크기 */
+/* Maximum size the user stack may grow to. */
+#define STACK_LIMIT (1 << 20)
+
+/* VMA가 어떤 영역을 나타내는지 */
+/* What kind of region a VMA describes. */
+enum vma_kind {
+	VMA_SEGMENT,    /* ELF 세그먼트, 익명 페이지로 지연 로딩 / ELF segment, lazily loaded as anon pages */
+	VMA_FILE,       /* mmap으로 매핑된 파일 / File mapped by mmap */
+	VMA_STACK,      /* 사용자 스택 / User stack */
+};
+
+/* 가상 메모리 영역(VMA).
+ * 연속된 페이지 범위 [start, end)가 하나의 백킹 정보를 공유합니다.
+ * 영역 안의 struct page는 처음 접근될 때 만들어집니다. */
+/* Virtual memory area.
+ * A page-aligned range [start, end) whose pages share one set of
+ * backing metadata.  The struct page for each page in the range
+ * is only created on first access. */
+struct vma {
+	void *start;            /* 첫 페이지 / First page. */
+	void *end;              /* 마지막 페이지 다음 / One past the last page. */
+	enum vma_kind kind;
+	bool writable;
+
+	struct file *file;      /* 백킹 파일, 스택이면 NULL / Backing file, NULL for the stack. */
+	off_t ofs;              /* START에 대응하는 파일 오프셋 / File offset of START. */
+	size_t read_bytes;      /* START부터 파일에서 읽을 바이트 수, 나머지는 0 / Bytes read from FILE, rest is zeroed. */
+
+	struct list pages;      /* 이미 만들어진 페이지들 / Pages materialized so far. */
+	struct rb_elem elem;    /* spt의 VMA 트리 요소 / Element in the spt's VMA tree. */
+};
+
+void vma_init (struct supplemental_page_table *spt);
+struct vma *vma_create (struct supplemental_page_table *spt,
+		enum vma_kind kind, void *start, void *end, bool writable,
+		struct file *file, off_t ofs, size_t read_bytes);
+struct vma *vma_find (struct supplemental_page_table *spt, const void *va);
+bool vma_overlaps (struct supplemental_page_table *spt,
+		const void *start, const void *end);
+struct vma *vma_first_in (struct supplemental_page_table *spt,
+		const void *start, const void *end);
+struct vma *vma_next (struct vma *vma);
+struct page *vma_materialize (struct supplemental_page_table *spt,
+		struct vma *vma, void *va);
+void vma_destroy (struct supplemental_page_table *spt, struct vma *vma);
+bool vma_copy (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src);
+void vma_kill (struct supplemental_page_table *spt);
+
+#endif /* VM_VMA_H */
@@ -3,6 +3,7 @@
 #include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include "threads/malloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
@@ -21,12 +22,25 @@ typedef unsigned long elem_type;
 /* Number of bits in an element. */
 #define ELEM_BITS (sizeof (elem_type) * CHAR_BIT)
 
+/* Bitmaps with at least this many elements keep a summary. */
+#define SUMMARY_MIN_ELEMS 16
+
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Large bitmaps also keep a summary with two bits per element:
+   one in the first half of the summary that may be set only if
+   the element has a bit set to false, and one in the second half
+   that may be set only if it has a bit set to true.  A scan
+   skips ELEM_BITS elements at a time by looking at the summary,
+   so finding a free bit in a nearly full bitmap takes time
+   proportional to the size of the bitmap divided by ELEM_BITS
+   squared. */
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	elem_type *summary; /* Summary, or a null pointer if small. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -62,6 +76,126 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns the number of summary elements for each value in a
+   bitmap of BIT_CNT bits, or 0 if it keeps no summary. */
+static inline size_t
+summary_cnt (size_t bit_cnt) {
+	size_t elems = elem_cnt (bit_cnt);
+	return elems >= SUMMARY_MIN_ELEMS ? elem_cnt (elems) : 0;
+}
+
+/* Returns element IDX of B with the bits set to VALUE turned on
+   and all others, including those past the end of B, turned
+   off. */
+static inline elem_type
+value_elem (const struct bitmap *b, size_t idx, bool value) {
+	elem_type elem = value ? b->bits[idx] : ~b->bits[idx];
+	if (idx == elem_cnt (b->bit_cnt) - 1)
+		elem &= last_mask (b);
+	return elem;
+}
+
+/* Returns the number of bits set to 1 in ELEM. */
+static inline size_t
+count_ones (elem_type elem) {
+	size_t cnt = 0;
+	for (; elem != 0; elem &= elem - 1)
+		cnt++;
+	return cnt;
+}
+
+/* Atomically ORs MASK into *ELEM. */
+static inline void
+elem_or (elem_type *elem, elem_type mask) {
+	asm ("lock orq %1, %0" : "+m" (*elem) : "r" (mask) : "cc");
+}
+
+/* Atomically ANDs MASK into *ELEM. */
+static inline void
+elem_and (elem_type *elem, elem_type mask) {
+	asm ("lock andq %1, %0" : "+m" (*elem) : "r" (mask) : "cc");
+}
+
+/* Brings the summary bits of element IDX of B up to date after a
+   change to the element.
+
+   Bits change without locking, so a summary bit is only cleared
+   if the element looks like it has no bit of that value, and is
+   set again if the element gained one meanwhile.  Whoever makes
+   that change sets the summary bit only after it, so the summary
+   bit ends up set either way. */
+static void
+update_summary (struct bitmap *b, size_t idx) {
+	size_t cnt = summary_cnt (b->bit_cnt);
+
+	if (cnt == 0)
+		return;
+	for (int value = 0; value < 2; value++) {
+		elem_type *summary = &b->summary[value * cnt + elem_idx (idx)];
+
+		if (value_elem (b, idx, value) != 0)
+			elem_or (summary, bit_mask (idx));
+		else {
+			elem_and (summary, ~bit_mask (idx));
+			if (value_elem (b, idx, value) != 0)
+				elem_or (summary, bit_mask (idx));
+		}
+	}
+}
+
+/* Returns the index of the first element of B at or after IDX
+   that may have a bit set to VALUE, or elem_cnt (B->bit_cnt) if
+   there is none. */
+static size_t
+next_elem (const struct bitmap *b, size_t idx, bool value) {
+	size_t elems = elem_cnt (b->bit_cnt);
+	size_t cnt = summary_cnt (b->bit_cnt);
+	const elem_type *summary;
+	size_t sidx;
+	elem_type elem;
+
+	if (idx >= elems)
+		return elems;
+	if (cnt == 0) {
+		while (idx < elems && value_elem (b, idx, value) == 0)
+			idx++;
+		return idx;
+	}
+
+	summary = &b->summary[value * cnt];
+	sidx = elem_idx (idx);
+	elem = summary[sidx] & ((elem_type) -1 << (idx % ELEM_BITS));
+	while (elem == 0) {
+		if (++sidx >= cnt)
+			return elems;
+		elem = summary[sidx];
+	}
+	return sidx * ELEM_BITS + __builtin_ctzl (elem);
+}
+
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or B->bit_cnt if there is none. */
+static size_t
+next_bit (const struct bitmap *b, size_t start, bool value) {
+	size_t elems = elem_cnt (b->bit_cnt);
+	size_t idx = elem_idx (start);
+	elem_type elem;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	elem = value_elem (b, idx, value) & ((elem_type) -1 << (start % ELEM_BITS));
+	while (elem == 0) {
+		/* The summary may be stale in the direction of having
+		   bits set, so check each element it points to. */
+		idx = next_elem (b, idx + 1, value);
+		if (idx >= elems)
+			return b->bit_cnt;
+		elem = value_elem (b, idx, value);
+	}
+	return idx * ELEM_BITS + __builtin_ctzl (elem);
+}
 
 /* Creation and destruction. */
 
@@ -73,9 +207,14 @@ struct bitmap *
 bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
+		size_t summary_size = 2 * summary_cnt (bit_cnt) * sizeof (elem_type);
+
 		b->bit_cnt = bit_cnt;
-		b->bits = malloc (byte_cnt (bit_cnt));
+		b->bits = malloc (byte_cnt (bit_cnt) + summary_size);
 		if (b->bits != NULL || bit_cnt == 0) {
+			b->summary = b->bits + elem_cnt (bit_cnt);
+			if (summary_size > 0)
+				memset (b->summary, 0, summary_size);
 			bitmap_set_all (b, false);
 			return b;
 		}
@@ -95,6 +234,8 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 
 	b->bit_cnt = bit_cnt;
 	b->bits = (elem_type *) (b + 1);
+	b->summary = b->bits + elem_cnt (bit_cnt);
+	memset (b->summary, 0, 2 * summary_cnt (bit_cnt) * sizeof (elem_type));
 	bitmap_set_all (b, false);
 	return b;
 }
@@ -103,7 +244,8 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
    with BIT_CNT bits (for use with bitmap_create_in_buf()). */
 size_t
 bitmap_buf_size (size_t bit_cnt) {
-	return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+	return sizeof (struct bitmap) + byte_cnt (bit_cnt)
+		+ 2 * summary_cnt (bit_cnt) * sizeof (elem_type);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -148,6 +290,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the OR instruction in [IA32-v2b]. */
 	asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -160,6 +303,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +318,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -194,33 +339,54 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Returns a mask of the bits of the element that contains bit
+   IDX that lie between IDX and END, exclusive, and stores their
+   number into *CNT. */
+static inline elem_type
+range_mask (size_t idx, size_t end, size_t *cnt) {
+	size_t ofs = idx % ELEM_BITS;
+
+	*cnt = ELEM_BITS - ofs < end - idx ? ELEM_BITS - ofs : end - idx;
+	return (*cnt == ELEM_BITS ? (elem_type) -1
+			: ((elem_type) 1 << *cnt) - 1) << ofs;
+}
+
+/* Sets the CNT bits starting at START in B to VALUE.
+   Works an element at a time; each element is set atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t i, end = start + cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	for (i = start; i < end; i += cnt) {
+		elem_type mask = range_mask (i, end, &cnt);
+
+		if (value)
+			elem_or (&b->bits[elem_idx (i)], mask);
+		else
+			elem_and (&b->bits[elem_idx (i)], ~mask);
+		update_summary (b, elem_idx (i));
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t i, end = start + cnt, value_cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	for (i = start; i < end; i += cnt) {
+		elem_type mask = range_mask (i, end, &cnt);
+		value_cnt += count_ones (value_elem (b, elem_idx (i), value) & mask);
+	}
 	return value_cnt;
 }
 
@@ -228,16 +394,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	return cnt > 0 && next_bit (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -272,16 +433,43 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
+	if (cnt == 0)
+		return start;
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
+		size_t i = start;
+
+		/* Jump from the start of each run of VALUE bits to its
+		   end, skipping whole elements on the way. */
+		while (i <= last) {
+			size_t end;
+
+			i = next_bit (b, i, value);
+			if (i > last)
+				break;
+			end = next_bit (b, i, !value);
+			if (end - i >= cnt)
 				return i;
+			i = end;
+		}
 	}
 	return BITMAP_ERROR;
 }
 
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE.
+   If there is no such bit, returns BITMAP_ERROR. */
+size_t
+bitmap_find_first (const struct bitmap *b, size_t start, bool value) {
+	size_t idx;
+
+	ASSERT (b != NULL);
+	ASSERT (start <= b->bit_cnt);
+
+	idx = next_bit (b, start, value);
+	return idx < b->bit_cnt ? idx : BITMAP_ERROR;
+}
+
 /* Finds the first group of CNT consecutive bits in B at or after
    START that are all set to VALUE, flips them all to !VALUE,
    and returns the index of the first bit in the group.
@@ -315,6 +503,8 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		for (size_t i = 0; i < elem_cnt (b->bit_cnt); i++)
+			update_summary (b, i);
 	}
 	return success;
 }
@@ -326,6 +516,23 @@ bitmap_write (const struct bitmap *b, struct file *file) {
 	off_t size = byte_cnt (b->bit_cnt);
 	return file_write_at (file, b->bits, size, 0) == size;
 }
+
+/* Writes bytes OFS through OFS + SIZE - 1 of B's file image, as
+   written by bitmap_write(), to the same place in FILE.  The
+   range is clipped to the end of the image.  Return true if
+   successful, false otherwise. */
+bool
+bitmap_write_part (const struct bitmap *b, struct file *file,
+		size_t ofs, size_t size) {
+	size_t file_size = byte_cnt (b->bit_cnt);
+
+	if (ofs >= file_size)
+		return true;
+	if (size > file_size - ofs)
+		size = file_size - ofs;
+	return file_write_at (file, (uint8_t *) b->bits + ofs, size, ofs)
+		== (off_t) size;
+}
 #endif /* FILESYS */
 
 /* Debugging. */
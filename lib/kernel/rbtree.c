@@ -0,0 +1,364 @@
+/* Red-black tree.
+
+   The algorithms follow the presentation in CLRS, "Introduction
+   to Algorithms", chapter 13, with null pointers standing in for
+   the black sentinel leaves.
+
+   See rbtree.h for basic information. */
+
+#include "rbtree.h"
+#include "../debug.h"
+
+static void rotate_left (struct rb_tree *, struct rb_elem *);
+static void rotate_right (struct rb_tree *, struct rb_elem *);
+static void transplant (struct rb_tree *, struct rb_elem *, struct rb_elem *);
+static void insert_fixup (struct rb_tree *, struct rb_elem *);
+static void delete_fixup (struct rb_tree *, struct rb_elem *,
+		struct rb_elem *);
+static struct rb_elem *subtree_min (struct rb_elem *);
+
+/* 널 리프는 검은색으로 취급합니다. */
+/* Null leaves count as black. */
+static inline bool
+is_red (const struct rb_elem *e) {
+	return e != NULL && e->red;
+}
+
+/* Initializes tree T to compare elements using LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *t, rb_less_func *less, void *aux) {
+	t->root = NULL;
+	t->elem_cnt = 0;
+	t->less = less;
+	t->aux = aux;
+}
+
+/* NEW를 트리 T에 삽입합니다. 같은 요소가 이미 있으면 삽입하지 않고
+   그 요소를 반환하며, 그렇지 않으면 null 포인터를 반환합니다. */
+/* Inserts NEW into tree T and returns a null pointer, if no
+   equal element is already in the tree.
+   If an equal element is already in the tree, returns it
+   without inserting NEW. */
+struct rb_elem *
+rb_insert (struct rb_tree *t, struct rb_elem *new) {
+	struct rb_elem *parent = NULL;
+	struct rb_elem **link = &t->root;
+
+	while (*link != NULL) {
+		parent = *link;
+		if (t->less (new, parent, t->aux))
+			link = &parent->left;
+		else if (t->less (parent, new, t->aux))
+			link = &parent->right;
+		else
+			return parent;
+	}
+
+	new->parent = parent;
+	new->left = new->right = NULL;
+	new->red = true;
+	*link = new;
+
+	insert_fixup (t, new);
+	t->elem_cnt++;
+	return NULL;
+}
+
+/* Removes E, which must be in tree T. */
+void
+rb_delete (struct rb_tree *t, struct rb_elem *e) {
+	struct rb_elem *y = e;
+	struct rb_elem *x, *x_parent;
+	bool y_red = y->red;
+
+	ASSERT (t->elem_cnt > 0);
+
+	if (e->left == NULL) {
+		x = e->right;
+		x_parent = e->parent;
+		transplant (t, e, e->right);
+	} else if (e->right == NULL) {
+		x = e->left;
+		x_parent = e->parent;
+		transplant (t, e, e->left);
+	} else {
+		y = subtree_min (e->right);
+		y_red = y->red;
+		x = y->right;
+		if (y->parent == e)
+			x_parent = y;
+		else {
+			x_parent = y->parent;
+			transplant (t, y, y->right);
+			y->right = e->right;
+			y->right->parent = y;
+		}
+		transplant (t, e, y);
+		y->left = e->left;
+		y->left->parent = y;
+		y->red = e->red;
+	}
+
+	if (!y_red)
+		delete_fixup (t, x, x_parent);
+	t->elem_cnt--;
+}
+
+/* Finds and returns an element equal to E in tree T, or a null
+   pointer if no equal element exists in the tree. */
+struct rb_elem *
+rb_find (struct rb_tree *t, const struct rb_elem *e) {
+	struct rb_elem *cur = t->root;
+
+	while (cur != NULL) {
+		if (t->less (e, cur, t->aux))
+			cur = cur->left;
+		else if (t->less (cur, e, t->aux))
+			cur = cur->right;
+		else
+			return cur;
+	}
+	return NULL;
+}
+
+/* E보다 크지 않은 요소 중 가장 큰 요소를 반환합니다. */
+/* Returns the greatest element in tree T that is not greater
+   than E, or a null pointer if every element is greater. */
+struct rb_elem *
+rb_floor (struct rb_tree *t, const struct rb_elem *e) {
+	struct rb_elem *cur = t->root;
+	struct rb_elem *best = NULL;
+
+	while (cur != NULL) {
+		if (t->less (e, cur, t->aux))
+			cur = cur->left;
+		else {
+			best = cur;
+			cur = cur->right;
+		}
+	}
+	return best;
+}
+
+/* E보다 작지 않은 요소 중 가장 작은 요소를 반환합니다. */
+/* Returns the least element in tree T that is not less than E,
+   or a null pointer if every element is less. */
+struct rb_elem *
+rb_ceil (struct rb_tree *t, const struct rb_elem *e) {
+	struct rb_elem *cur = t->root;
+	struct rb_elem *best = NULL;
+
+	while (cur != NULL) {
+		if (t->less (cur, e, t->aux))
+			cur = cur->right;
+		else {
+			best = cur;
+			cur = cur->left;
+		}
+	}
+	return best;
+}
+
+/* Returns the least element in tree T, or a null pointer if T
+   is empty. */
+struct rb_elem *
+rb_first (struct rb_tree *t) {
+	return t->root != NULL ? subtree_min (t->root) : NULL;
+}
+
+/* Returns the element that follows E in sorted order, or a null
+   pointer if E is the greatest element in its tree. */
+struct rb_elem *
+rb_next (struct rb_elem *e) {
+	if (e->right != NULL)
+		return subtree_min (e->right);
+
+	while (e->parent != NULL && e == e->parent->right)
+		e = e->parent;
+	return e->parent;
+}
+
+/* Returns the number of elements in T. */
+size_t
+rb_size (struct rb_tree *t) {
+	return t->elem_cnt;
+}
+
+/* Returns true if T contains no elements, false otherwise. */
+bool
+rb_empty (struct rb_tree *t) {
+	return t->elem_cnt == 0;
+}
+
+/* Returns the least element in the subtree rooted at E. */
+static struct rb_elem *
+subtree_min (struct rb_elem *e) {
+	while (e->left != NULL)
+		e = e->left;
+	return e;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's
+   right child takes its place. */
+static void
+rotate_left (struct rb_tree *t, struct rb_elem *x) {
+	struct rb_elem *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+	y->parent = x->parent;
+	if (x->parent == NULL)
+		t->root = y;
+	else if (x == x->parent->left)
+		x->parent->left = y;
+	else
+		x->parent->right = y;
+	y->left = x;
+	x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's
+   left child takes its place. */
+static void
+rotate_right (struct rb_tree *t, struct rb_elem *x) {
+	struct rb_elem *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+	y->parent = x->parent;
+	if (x->parent == NULL)
+		t->root = y;
+	else if (x == x->parent->right)
+		x->parent->right = y;
+	else
+		x->parent->left = y;
+	y->right = x;
+	x->parent = y;
+}
+
+/* Replaces the subtree rooted at U by the subtree rooted at V,
+   which may be null. */
+static void
+transplant (struct rb_tree *t, struct rb_elem *u, struct rb_elem *v) {
+	if (u->parent == NULL)
+		t->root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+/* Restores the red-black properties after inserting red
+   element Z. */
+static void
+insert_fixup (struct rb_tree *t, struct rb_elem *z) {
+	while (is_red (z->parent)) {
+		/* 부모가 빨간색이면 루트가 아니므로 조부모가 존재합니다. */
+		/* A red parent is never the root, so Z has a grandparent. */
+		struct rb_elem *gp = z->parent->parent;
+
+		if (z->parent == gp->left) {
+			struct rb_elem *uncle = gp->right;
+			if (is_red (uncle)) {
+				z->parent->red = false;
+				uncle->red = false;
+				gp->red = true;
+				z = gp;
+			} else {
+				if (z == z->parent->right) {
+					z = z->parent;
+					rotate_left (t, z);
+				}
+				z->parent->red = false;
+				gp->red = true;
+				rotate_right (t, gp);
+			}
+		} else {
+			struct rb_elem *uncle = gp->left;
+			if (is_red (uncle)) {
+				z->parent->red = false;
+				uncle->red = false;
+				gp->red = true;
+				z = gp;
+			} else {
+				if (z == z->parent->left) {
+					z = z->parent;
+					rotate_right (t, z);
+				}
+				z->parent->red = false;
+				gp->red = true;
+				rotate_left (t, gp);
+			}
+		}
+	}
+	t->root->red = false;
+}
+
+/* Restores the red-black properties after removing a black
+   element.  X, which may be null, carries the extra black and
+   PARENT is its parent. */
+static void
+delete_fixup (struct rb_tree *t, struct rb_elem *x, struct rb_elem *parent) {
+	while (x != t->root && !is_red (x)) {
+		if (x == parent->left) {
+			struct rb_elem *w = parent->right;
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_left (t, parent);
+				w = parent->right;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->right)) {
+					w->left->red = false;
+					w->red = true;
+					rotate_right (t, w);
+					w = parent->right;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->right->red = false;
+				rotate_left (t, parent);
+				x = t->root;
+				parent = NULL;
+			}
+		} else {
+			struct rb_elem *w = parent->left;
+			if (is_red (w)) {
+				w->red = false;
+				parent->red = true;
+				rotate_right (t, parent);
+				w = parent->left;
+			}
+			if (!is_red (w->left) && !is_red (w->right)) {
+				w->red = true;
+				x = parent;
+				parent = x->parent;
+			} else {
+				if (!is_red (w->left)) {
+					w->right->red = false;
+					w->red = true;
+					rotate_left (t, w);
+					w = parent->left;
+				}
+				w->red = parent->red;
+				parent->red = false;
+				w->left->red = false;
+				rotate_right (t, parent);
+				x = t->root;
+				parent = NULL;
+			}
+		}
+	}
+	if (x != NULL)
+		x->red = false;
+}
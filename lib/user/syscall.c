@@ -41,7 +41,7 @@ __attribute__((always_inline)) static __inline int64_t syscall(uint64_t num_, ui
 
 #define syscall3(NUMBER, ARG0, ARG1, ARG2) (syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), 0, 0, 0))
 
-#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) (syscall(((uint64_t *)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), ((uint64_t)ARG3), 0, 0))
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) (syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), ((uint64_t)ARG3), 0, 0))
 
 #define syscall5(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4) (syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), ((uint64_t)ARG3), ((uint64_t)ARG4), 0))
 void halt(void) {
@@ -114,6 +114,42 @@ void munmap(void *addr) {
     syscall1(SYS_MUNMAP, addr);
 }
 
+int msync(void *addr, size_t length) {
+    return syscall2(SYS_MSYNC, addr, length);
+}
+
+int vmstat(struct vm_stats *stats) {
+    return syscall1(SYS_VMSTAT, stats);
+}
+
+int punch_hole(int fd, off_t offset, off_t length) {
+    return syscall3(SYS_PUNCH_HOLE, fd, offset, length);
+}
+
+int pread(int fd, void *buffer, unsigned length, off_t offset) {
+    return syscall4(SYS_PREAD, fd, buffer, length, offset);
+}
+
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset) {
+    return syscall4(SYS_PWRITE, fd, buffer, length, offset);
+}
+
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int sendfile(int out_fd, int in_fd, unsigned length) {
+    return syscall3(SYS_SENDFILE, out_fd, in_fd, length);
+}
+
+int getdents(int fd, struct dirent *buf, unsigned size) {
+    return syscall3(SYS_GETDENTS, fd, buf, size);
+}
+
 bool chdir(const char *dir) {
     return syscall1(SYS_CHDIR, dir);
 }
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+my ($blocks) = random_bytes (3 * 512);
+my ($data) = "\0" x 100512;
+substr ($data, 0, 512) = substr ($blocks, 0, 512);
+substr ($data, 100000, 512) = substr ($blocks, 512, 512);
+substr ($data, 40000, 512) = substr ($blocks, 1024, 512);
+check_archive ({"testfile" => [$data]});
+pass;
@@ -0,0 +1,37 @@
+/* Writes blocks at the start and far past the end of a file, then
+   fills one block in the middle of the hole left between them,
+   and checks that every unwritten byte reads as zero. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 512
+
+static char buf[100000 + BLOCK_SIZE];
+static char blocks[3][BLOCK_SIZE];
+static const size_t offsets[3] = {0, 100000, 40000};
+
+void
+test_main (void)
+{
+  int fd;
+  size_t i;
+
+  random_bytes (blocks, sizeof blocks);
+  CHECK (create ("testfile", 0), "create \"testfile\"");
+  CHECK ((fd = open ("testfile")) > 1, "open \"testfile\"");
+  for (i = 0; i < 3; i++)
+    {
+      seek (fd, offsets[i]);
+      CHECK (write (fd, blocks[i], BLOCK_SIZE) == BLOCK_SIZE,
+             "write %d bytes at offset %zu", BLOCK_SIZE, offsets[i]);
+      memcpy (buf + offsets[i], blocks[i], BLOCK_SIZE);
+    }
+  msg ("close \"testfile\"");
+  close (fd);
+
+  check_file ("testfile", buf, sizeof buf);
+}
@@ -0,0 +1,40 @@
+/* Grows a file whose data starts out inside its inode past the
+   inline limit, so that the data has to move out to extents, and
+   checks the contents before and after the move. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[3000];
+
+/* Writes BUF[OFS, OFS + SIZE) to FD and checks the whole file. */
+static void
+append (int fd, size_t ofs, size_t size)
+{
+  CHECK (write (fd, buf + ofs, size) == (int) size,
+         "write %zu bytes at offset %zu", size, ofs);
+  check_file ("testfile", buf, ofs + size);
+}
+
+void
+test_main (void)
+{
+  int fd;
+
+  random_bytes (buf, sizeof buf);
+  CHECK (create ("testfile", 0), "create \"testfile\"");
+  CHECK ((fd = open ("testfile")) > 1, "open \"testfile\"");
+
+  /* Small enough to stay inline. */
+  append (fd, 0, 100);
+  append (fd, 100, 300);
+
+  /* Moves the data out of the inode. */
+  append (fd, 400, 600);
+  append (fd, 1000, 2000);
+
+  msg ("close \"testfile\"");
+  close (fd);
+}
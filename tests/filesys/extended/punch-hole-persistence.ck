@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+my ($data) = random_bytes (20000);
+my ($file) = $data;
+substr ($file, 1000, 10000) = "\0" x 10000;
+substr ($file, 15000) = "\0" x 5000;
+substr ($file, 5000, 512) = substr ($data, 5000, 512);
+check_archive ({"testfile" => [$file]});
+pass;
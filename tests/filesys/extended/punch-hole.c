@@ -0,0 +1,47 @@
+/* Punches holes into a file, one in the middle with unaligned
+   edges and one running past end of file, then writes into the
+   first hole again.  Checks that the holes read as zeros, that
+   the file keeps its length, and that bad arguments fail. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE 20000
+
+static char data[FILE_SIZE];
+static char buf[FILE_SIZE];
+
+void
+test_main (void)
+{
+  int fd;
+
+  random_bytes (data, sizeof data);
+  memcpy (buf, data, sizeof buf);
+  CHECK (create ("testfile", 0), "create \"testfile\"");
+  CHECK ((fd = open ("testfile")) > 1, "open \"testfile\"");
+  CHECK (write (fd, data, sizeof data) == FILE_SIZE, "write \"testfile\"");
+
+  CHECK (punch_hole (fd, 1000, 10000) == 0, "punch 10000 bytes at 1000");
+  memset (buf + 1000, 0, 10000);
+  CHECK (punch_hole (fd, 15000, 100000) == 0, "punch past end of file");
+  memset (buf + 15000, 0, FILE_SIZE - 15000);
+  CHECK (filesize (fd) == FILE_SIZE, "file size unchanged");
+  check_file ("testfile", buf, sizeof buf);
+
+  msg ("fill part of the hole");
+  seek (fd, 5000);
+  CHECK (write (fd, data + 5000, 512) == 512, "write 512 bytes at 5000");
+  memcpy (buf + 5000, data + 5000, 512);
+  check_file ("testfile", buf, sizeof buf);
+
+  CHECK (punch_hole (fd, -1, 10) == -1, "punch at negative offset");
+  CHECK (punch_hole (fd, 0, -1) == -1, "punch negative length");
+  CHECK (punch_hole (0x01012342, 0, 10) == -1, "punch bad fd");
+
+  msg ("close \"testfile\"");
+  close (fd);
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(punch-hole) begin
+(punch-hole) create "testfile"
+(punch-hole) open "testfile"
+(punch-hole) write "testfile"
+(punch-hole) punch 10000 bytes at 1000
+(punch-hole) punch past end of file
+(punch-hole) file size unchanged
+(punch-hole) open "testfile" for verification
+(punch-hole) verified contents of "testfile"
+(punch-hole) close "testfile"
+(punch-hole) fill part of the hole
+(punch-hole) write 512 bytes at 5000
+(punch-hole) open "testfile" for verification
+(punch-hole) verified contents of "testfile"
+(punch-hole) close "testfile"
+(punch-hole) punch at negative offset
+(punch-hole) punch negative length
+(punch-hole) punch bad fd
+(punch-hole) close "testfile"
+(punch-hole) end
+EOF
+pass;
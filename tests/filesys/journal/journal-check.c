@@ -0,0 +1,25 @@
+/* Run by the boot after journal-replay, once the journal's log
+   has been replayed.  Checks that the files journal-replay wrote
+   are there with their contents and that the one it removed is
+   gone. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/filesys/journal/journal.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  size_t ofs = 0;
+  int i;
+
+  random_bytes (buf, sizeof buf);
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      check_file (file_names[i], buf + ofs, file_sizes[i]);
+      ofs += file_sizes[i];
+    }
+  CHECK (open (REMOVED_FILE) == -1, "\"%s\" is gone", REMOVED_FILE);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+fail "The journal's log was not replayed.\n"
+  if !grep (/^journal: replayed \d+ transaction\(s\)$/, @output);
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(journal-check) begin
+(journal-check) open "a" for verification
+(journal-check) verified contents of "a"
+(journal-check) close "a"
+(journal-check) open "b" for verification
+(journal-check) verified contents of "b"
+(journal-check) close "b"
+(journal-check) open "c" for verification
+(journal-check) verified contents of "c"
+(journal-check) close "c"
+(journal-check) "gone" is gone
+(journal-check) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Creates and writes small files and removes another, with the
+   kernel's -crash option set, so that at power off the changes
+   are only in the journal's log.  journal-check then checks them
+   on the next boot, after the log is replayed. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/filesys/journal/journal.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  size_t ofs = 0;
+  int i, fd;
+
+  random_bytes (buf, sizeof buf);
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      CHECK (create (file_names[i], 0), "create \"%s\"", file_names[i]);
+      CHECK ((fd = open (file_names[i])) > 1, "open \"%s\"", file_names[i]);
+      CHECK (write (fd, buf + ofs, file_sizes[i]) == (int) file_sizes[i],
+             "write \"%s\"", file_names[i]);
+      msg ("close \"%s\"", file_names[i]);
+      close (fd);
+      ofs += file_sizes[i];
+    }
+
+  CHECK (create (REMOVED_FILE, 50), "create \"%s\"", REMOVED_FILE);
+  CHECK (remove (REMOVED_FILE), "remove \"%s\"", REMOVED_FILE);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(journal-replay) begin
+(journal-replay) create "a"
+(journal-replay) open "a"
+(journal-replay) write "a"
+(journal-replay) close "a"
+(journal-replay) create "b"
+(journal-replay) open "b"
+(journal-replay) write "b"
+(journal-replay) close "b"
+(journal-replay) create "c"
+(journal-replay) open "c"
+(journal-replay) write "c"
+(journal-replay) close "c"
+(journal-replay) create "gone"
+(journal-replay) remove "gone"
+(journal-replay) end
+EOF
+pass;
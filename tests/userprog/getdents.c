@@ -0,0 +1,68 @@
+/* Creates a set of files in the root directory and lists it with
+   getdents through a buffer that holds only a few records, so
+   that it takes several calls.  Checks that each file shows up
+   exactly once with the right size and type. */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 20
+
+void
+test_main (void)
+{
+  struct dirent ents[8];
+  bool seen[FILE_CNT];
+  char name[16];
+  int fd, file_fd, found = 0, n, i, calls = 0;
+
+  msg ("create files");
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "file%d", i);
+      if (!create (name, i * 10))
+        fail ("create \"%s\" failed", name);
+      seen[i] = false;
+    }
+
+  CHECK ((fd = open ("/")) > 1, "open \"/\"");
+  msg ("read directory");
+  while ((n = getdents (fd, ents, sizeof ents)) > 0)
+    {
+      calls++;
+      if (n % sizeof ents[0] != 0)
+        fail ("getdents returned %d bytes, not a whole number of records", n);
+      for (i = 0; i < n / (int) sizeof ents[0]; i++)
+        {
+          struct dirent *d = &ents[i];
+          int idx;
+
+          if (memcmp (d->d_name, "file", 4) != 0)
+            continue;
+          idx = atoi (d->d_name + 4);
+          if (idx < 0 || idx >= FILE_CNT)
+            fail ("unexpected entry \"%s\"", d->d_name);
+          if (seen[idx])
+            fail ("\"%s\" listed twice", d->d_name);
+          if (d->d_type != DT_REG || d->d_size != (uint32_t) idx * 10)
+            fail ("\"%s\" has type %d and size %u", d->d_name,
+                  d->d_type, (unsigned) d->d_size);
+          seen[idx] = true;
+          found++;
+        }
+    }
+  CHECK (n == 0, "getdents reached end of directory");
+  CHECK (found == FILE_CNT, "found every file once");
+  CHECK (calls > 1, "listing took several calls");
+  close (fd);
+
+  CHECK ((file_fd = open ("file0")) > 1, "open \"file0\"");
+  CHECK (getdents (file_fd, ents, sizeof ents) == -1,
+         "getdents on a regular file");
+  close (file_fd);
+}
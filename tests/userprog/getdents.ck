@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(getdents) begin
+(getdents) create files
+(getdents) open "/"
+(getdents) read directory
+(getdents) getdents reached end of directory
+(getdents) found every file once
+(getdents) listing took several calls
+(getdents) open "file0"
+(getdents) getdents on a regular file
+(getdents) end
+getdents: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Reads and writes "sample.txt" at explicit offsets with pread
+   and pwrite, and checks that neither moves the file position
+   used by read. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[128];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  CHECK (pread (handle, buf, 100, 50) == 100, "pread 100 bytes at 50");
+  compare_bytes (buf, sample + 50, 100, 50, "sample.txt");
+  CHECK (tell (handle) == 0, "file position unchanged");
+  CHECK (pread (handle, buf, 100, sizeof sample + 100) == 0,
+         "pread past end of file");
+
+  memcpy (sample + 200, "Pintos", 6);
+  CHECK (pwrite (handle, "Pintos", 6, 200) == 6, "pwrite 6 bytes at 200");
+  CHECK (tell (handle) == 0, "file position unchanged");
+  CHECK (pread (handle, buf, 100, 150) == 100, "pread 100 bytes at 150");
+  compare_bytes (buf, sample + 150, 100, 150, "sample.txt");
+
+  CHECK (pread (handle, buf, 10, -1) == -1, "pread at negative offset");
+  CHECK (pwrite (handle, buf, 10, -1) == -1, "pwrite at negative offset");
+  CHECK (pread (0x01012342, buf, 10, 0) == -1, "pread bad fd");
+
+  close (handle);
+  check_file ("sample.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) open "sample.txt"
+(pread-pwrite) pread 100 bytes at 50
+(pread-pwrite) file position unchanged
+(pread-pwrite) pread past end of file
+(pread-pwrite) pwrite 6 bytes at 200
+(pread-pwrite) file position unchanged
+(pread-pwrite) pread 100 bytes at 150
+(pread-pwrite) pread at negative offset
+(pread-pwrite) pwrite at negative offset
+(pread-pwrite) pread bad fd
+(pread-pwrite) open "sample.txt" for verification
+(pread-pwrite) verified contents of "sample.txt"
+(pread-pwrite) close "sample.txt"
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
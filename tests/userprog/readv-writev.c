@@ -0,0 +1,58 @@
+/* Gathers pieces of the sample text into a file with writev and
+   scatters them back out with readv, using buffers of different
+   sizes for each.  Also writes a line to the console with writev
+   and checks that bad buffer counts fail. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include <uio.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char bufs[3][512];
+
+void
+test_main (void)
+{
+  struct iovec iov[3];
+  size_t size = sizeof sample - 1;
+  int handle;
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = 10;
+  iov[1].iov_base = sample + 10;
+  iov[1].iov_len = 300;
+  iov[2].iov_base = sample + 310;
+  iov[2].iov_len = size - 310;
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (writev (handle, iov, 3) == (int) size, "writev 3 buffers");
+  close (handle);
+  check_file ("test.txt", sample, size);
+
+  iov[0].iov_base = bufs[0];
+  iov[0].iov_len = 100;
+  iov[1].iov_base = bufs[1];
+  iov[1].iov_len = 1;
+  iov[2].iov_base = bufs[2];
+  iov[2].iov_len = sizeof bufs[2];
+
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (readv (handle, iov, 3) == (int) size, "readv 3 buffers");
+  compare_bytes (bufs[0], sample, 100, 0, "test.txt");
+  compare_bytes (bufs[1], sample + 100, 1, 100, "test.txt");
+  compare_bytes (bufs[2], sample + 101, size - 101, 101, "test.txt");
+
+  CHECK (readv (handle, iov, 0) == -1, "readv 0 buffers");
+  CHECK (readv (handle, iov, IOV_MAX + 1) == -1, "readv too many buffers");
+  close (handle);
+
+  iov[0].iov_base = (char *) "(readv-writev) writev to ";
+  iov[0].iov_len = strlen (iov[0].iov_base);
+  iov[1].iov_base = (char *) "the console\n";
+  iov[1].iov_len = strlen (iov[1].iov_base);
+  writev (STDOUT_FILENO, iov, 2);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "test.txt"
+(readv-writev) open "test.txt"
+(readv-writev) writev 3 buffers
+(readv-writev) open "test.txt" for verification
+(readv-writev) verified contents of "test.txt"
+(readv-writev) close "test.txt"
+(readv-writev) open "test.txt"
+(readv-writev) readv 3 buffers
+(readv-writev) readv 0 buffers
+(readv-writev) readv too many buffers
+(readv-writev) writev to the console
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Copies "sample.txt" into a new file with sendfile, then sends
+   its first line to the console, and checks that both files'
+   positions advance by the number of bytes moved. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int size = sizeof sample - 1;
+  int line = strchr (sample, '\n') - sample + 1;
+  int in, out;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", 0), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  CHECK (sendfile (out, in, size) == size, "sendfile to \"copy.txt\"");
+  CHECK (tell (in) == (unsigned) size && tell (out) == (unsigned) size,
+         "file positions advanced");
+  CHECK (sendfile (out, in, 10) == 0, "sendfile at end of file");
+  CHECK (sendfile (out, 0x01012342, 10) == -1, "sendfile bad fd");
+  close (out);
+  check_file ("copy.txt", sample, size);
+
+  msg ("sendfile first line to the console");
+  seek (in, 0);
+  CHECK (sendfile (STDOUT_FILENO, in, line) == line,
+         "sendfile to the console");
+  close (in);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile) begin
+(sendfile) open "sample.txt"
+(sendfile) create "copy.txt"
+(sendfile) open "copy.txt"
+(sendfile) sendfile to "copy.txt"
+(sendfile) file positions advanced
+(sendfile) sendfile at end of file
+(sendfile) sendfile bad fd
+(sendfile) open "copy.txt" for verification
+(sendfile) verified contents of "copy.txt"
+(sendfile) close "copy.txt"
+(sendfile) sendfile first line to the console
+"KAIST is the first and top science and technology university in Korea.
+(sendfile) sendfile to the console
+(sendfile) end
+sendfile: exit(0)
+EOF
+pass;
@@ -0,0 +1,41 @@
+/* Writes to a file through a mapping and flushes it with msync,
+   then reads the data back through another handle while the
+   mapping is still in place to verify. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  int handle, handle2;
+  void *map;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED, "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+
+  /* Flush the mapping without unmapping it. */
+  CHECK (msync ((char *) ACTUAL + 1, 4096) == -1, "msync misaligned address");
+  CHECK (msync (ACTUAL, 8192) == -1, "msync past end of mapping");
+  CHECK (msync (ACTUAL, (size_t) -4096) == -1, "msync wrapping range");
+  CHECK (msync (ACTUAL, 4096) == 0, "msync \"sample.txt\"");
+
+  /* Read back via read() on a second handle. */
+  CHECK ((handle2 = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (read (handle2, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare read data against written data");
+  close (handle2);
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,72 @@
+/* Checks that vmstat counts lazy loading and stack growth
+   faults, and records a latency sample for each claimed page. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 16
+#define STACK_PAGES 4
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+static struct vm_stats before, after;
+
+/* Grows the stack by touching STACK_PAGES pages, top down, and
+   returns the sum of the page numbers read back from them. */
+static int
+grow_stack (void)
+{
+  volatile char stack_buf[STACK_PAGES * PAGE_SIZE];
+  int i, sum = 0;
+
+  for (i = STACK_PAGES * PAGE_SIZE - 1; i >= 0; i -= PAGE_SIZE)
+    stack_buf[i] = i / PAGE_SIZE;
+  for (i = STACK_PAGES * PAGE_SIZE - 1; i >= 0; i -= PAGE_SIZE)
+    sum += stack_buf[i];
+  return sum;
+}
+
+/* Returns the number of samples in TIMER's histogram. */
+static uint64_t
+hist_total (const struct vm_stats *stats, enum vm_timer timer)
+{
+  uint64_t total = 0;
+  int i;
+
+  for (i = 0; i < VM_HIST_BUCKETS; i++)
+    total += stats->hist[timer][i];
+  return total;
+}
+
+void
+test_main (void)
+{
+  size_t i;
+
+  memset (&before, 0, sizeof before);
+  memset (&after, 0, sizeof after);
+  CHECK (vmstat (&before) == 0, "vmstat");
+
+  msg ("touch pages");
+  for (i = 0; i < PAGE_COUNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  CHECK (grow_stack () == STACK_PAGES * (STACK_PAGES - 1) / 2,
+         "stack pages read back");
+
+  CHECK (vmstat (&after) == 0, "vmstat");
+  CHECK (after.faults[VMF_LAZY] - before.faults[VMF_LAZY] >= PAGE_COUNT,
+         "lazy load faults counted");
+  CHECK (after.faults[VMF_STACK] - before.faults[VMF_STACK] >= STACK_PAGES - 1,
+         "stack growth faults counted");
+  CHECK (after.faults[VMF_BAD] == before.faults[VMF_BAD],
+         "no bad faults");
+  CHECK (hist_total (&after, VMT_CLAIM) - hist_total (&before, VMT_CLAIM)
+         >= PAGE_COUNT, "claims recorded in histogram");
+  CHECK (after.cycles[VMT_CLAIM] > before.cycles[VMT_CLAIM],
+         "claim cycles counted");
+  CHECK (after.rss_limit == 0, "no rss limit");
+  CHECK (after.rss >= PAGE_COUNT && after.rss <= after.rss_peak,
+         "rss counts touched pages");
+}
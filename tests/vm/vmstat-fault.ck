@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-fault) begin
+(vmstat-fault) vmstat
+(vmstat-fault) touch pages
+(vmstat-fault) stack pages read back
+(vmstat-fault) vmstat
+(vmstat-fault) lazy load faults counted
+(vmstat-fault) stack growth faults counted
+(vmstat-fault) no bad faults
+(vmstat-fault) claims recorded in histogram
+(vmstat-fault) claim cycles counted
+(vmstat-fault) no rss limit
+(vmstat-fault) rss counts touched pages
+(vmstat-fault) end
+EOF
+pass;
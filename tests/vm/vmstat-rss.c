@@ -0,0 +1,41 @@
+/* Runs with a resident set limit of 32 pages and touches twice
+   as many pages, checking that the process evicts its own pages
+   to stay under the limit and that their contents survive. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 64
+#define RSS_LIMIT 32
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+static struct vm_stats stats;
+
+void
+test_main (void)
+{
+  size_t i;
+
+  memset (&stats, 0, sizeof stats);
+
+  msg ("touch pages");
+  for (i = 0; i < PAGE_COUNT; i++)
+    memset (buf + i * PAGE_SIZE, i, PAGE_SIZE);
+
+  CHECK (vmstat (&stats) == 0, "vmstat");
+  CHECK (stats.rss_limit == RSS_LIMIT, "rss limit is %d", RSS_LIMIT);
+  CHECK (stats.rss <= stats.rss_limit, "rss within limit");
+  CHECK (stats.rss_peak <= stats.rss_limit, "rss peak within limit");
+  CHECK (stats.rss <= stats.rss_peak, "rss at most rss peak");
+  CHECK (stats.rss <= stats.frames, "rss at most resident frames");
+  CHECK (stats.local_evictions > 0, "own pages evicted");
+
+  msg ("check pages");
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i
+        || buf[i * PAGE_SIZE + PAGE_SIZE - 1] != (char) i)
+      fail ("page %zu has wrong contents", i);
+}
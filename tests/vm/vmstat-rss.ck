@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-rss) begin
+(vmstat-rss) touch pages
+(vmstat-rss) vmstat
+(vmstat-rss) rss limit is 32
+(vmstat-rss) rss within limit
+(vmstat-rss) rss peak within limit
+(vmstat-rss) rss at most rss peak
+(vmstat-rss) rss at most resident frames
+(vmstat-rss) own pages evicted
+(vmstat-rss) check pages
+(vmstat-rss) end
+EOF
+pass;
@@ -36,6 +36,7 @@
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/page_cache.h"
 #endif
 
 /* 커널 매핑만을 포함하는 페이지 맵 레벨 4 */
@@ -242,6 +243,12 @@ parse_options (char **argv) {
 #ifdef FILESYS
 		else if (!strcmp (name, "-f"))
 			format_filesys = true;
+		else if (!strcmp (name, "-stripe"))
+			filesys_stripe_unit = atoi (value);
+		else if (!strcmp (name, "-ramfs"))
+			filesys_ram_mb = atoi (value);
+		else if (!strcmp (name, "-crash"))
+			filesys_crash = true;
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
@@ -250,6 +257,10 @@ parse_options (char **argv) {
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
+#ifdef VM
+		else if (!strcmp (name, "-rss"))
+			vm_rss_limit = atoi (value);
+#endif
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
 #endif
@@ -350,10 +361,18 @@ usage (void) {
 			"  -h                 Print this help message and power off.\n"
 			"  -q                 Power off VM after actions or on panic.\n"
 			"  -f                 Format file system disk during startup.\n"
+#ifdef FILESYS
+			"  -stripe=SECTORS    Stripe file system and swap over hd0:1 and hd1:1.\n"
+			"  -ramfs=MB          Keep the file system in a MB megabyte RAM disk.\n"
+			"  -crash             Leave the file system as after a crash at power off.\n"
+#endif
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -rss=COUNT         Limit each process to COUNT resident pages.\n"
 #endif
 			);
 	power_off ();
@@ -382,6 +401,10 @@ print_stats (void) {
 	thread_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
+	page_cache_print_stats ();
+#endif
+#ifdef VM
+	vm_print_stats ();
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
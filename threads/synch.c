@@ -435,3 +435,80 @@ void cond_broadcast(struct condition *cond, struct lock *lock) {
     while (!list_empty(&cond->waiters))
         cond_signal(cond, lock);
 }
+
+/* 읽기/쓰기 잠금 RW를 초기화합니다. 여러 스레드가 함께 읽기 잠금을 잡거나, 한 스레드만
+   쓰기 잠금을 잡을 수 있습니다. 쓰기를 기다리는 스레드가 있으면 새 읽기는 기다리므로
+   쓰는 쪽이 굶지 않습니다. 같은 스레드가 읽기 잠금을 겹쳐 잡아서는 안 됩니다. */
+/* Initializes reader/writer lock RW.  Any number of threads may
+   hold RW for reading at once, or a single thread may hold it for
+   writing.  New readers wait while a writer is waiting, so that
+   writers do not starve; for the same reason a thread must not
+   acquire RW for reading while already holding it. */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    lock_init(&rw->lock);
+    cond_init(&rw->readers);
+    cond_init(&rw->writers);
+    rw->active_readers = 0;
+    rw->waiting_writers = 0;
+    rw->writing = false;
+}
+
+/* RW를 읽기용으로 획득합니다. 필요하면 잠들 때까지 기다립니다. */
+/* Acquires RW for reading, sleeping until no writer holds it or
+   is waiting for it. */
+void rwlock_acquire_read(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    lock_acquire(&rw->lock);
+    while (rw->writing || rw->waiting_writers > 0)
+        cond_wait(&rw->readers, &rw->lock);
+    rw->active_readers++;
+    lock_release(&rw->lock);
+}
+
+/* 읽기용으로 잡은 RW를 해제합니다. */
+/* Releases RW, held for reading by the current thread. */
+void rwlock_release_read(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    lock_acquire(&rw->lock);
+    ASSERT(rw->active_readers > 0);
+    if (--rw->active_readers == 0)
+        cond_signal(&rw->writers, &rw->lock);
+    lock_release(&rw->lock);
+}
+
+/* RW를 쓰기용으로 획득합니다. 다른 모든 보유자가 놓을 때까지 기다립니다. */
+/* Acquires RW for writing, sleeping until no other thread holds
+   it. */
+void rwlock_acquire_write(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    lock_acquire(&rw->lock);
+    rw->waiting_writers++;
+    while (rw->writing || rw->active_readers > 0)
+        cond_wait(&rw->writers, &rw->lock);
+    rw->waiting_writers--;
+    rw->writing = true;
+    lock_release(&rw->lock);
+}
+
+/* 쓰기용으로 잡은 RW를 해제합니다. 기다리는 쓰기가 있으면 먼저 깨웁니다. */
+/* Releases RW, held for writing by the current thread.  A waiting
+   writer goes first; otherwise every waiting reader is woken. */
+void rwlock_release_write(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    lock_acquire(&rw->lock);
+    ASSERT(rw->writing);
+    rw->writing = false;
+    if (rw->waiting_writers > 0)
+        cond_signal(&rw->writers, &rw->lock);
+    else
+        cond_broadcast(&rw->readers, &rw->lock);
+    lock_release(&rw->lock);
+}
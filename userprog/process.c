@@ -22,6 +22,7 @@
 #include "userprog/tss.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/stat.h"
 #endif
 
 #include "threads/malloc.h"
@@ -204,6 +205,12 @@ static void __do_fork(void *aux) {
 
     process_activate(current);
 #ifdef VM
+    // 자식의 세그먼트 VMA가 참조할 실행 파일을 먼저 복제한다.
+    if (parent->running != NULL) {
+        current->running = file_duplicate(parent->running);
+        if (current->running == NULL)
+            goto error;
+    }
     supplemental_page_table_init(&current->spt);
     if (!supplemental_page_table_copy(&current->spt, &parent->spt))
         goto error;
@@ -514,7 +521,6 @@ static bool load(const char *file_name, struct intr_frame *if_) {
 
     /* (프로그램 파일) 실행 파일을 엽니다. */
     /* Open executable file. */
-    lock_acquire(&filesys_lock);
     file = filesys_open(file_name);
     if (file == NULL) {
         printf("load: %s: open failed\n", file_name);
@@ -601,7 +607,6 @@ static bool load(const char *file_name, struct intr_frame *if_) {
     success = true;
 
 done:
-    lock_release(&filesys_lock);
     /* 로드가 성공했든 실패했든 여기에 도착합니다. */
     /* We arrive here whether the load is successful or not. */
     if (!success)
@@ -874,6 +879,9 @@ bool lazy_load_segment(struct page *page, void *aux) {
         return false;
     }
     memset(page->frame->kva + read_bytes, 0, zero_bytes);
+    if (read_bytes == 0) {
+        vm_stat_event(VME_ZERO_FILL);
+    }
     return true;
 }
 
@@ -896,32 +904,11 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     ASSERT(pg_ofs(upage) == 0);
     ASSERT(ofs % PGSIZE == 0);
 
-    while (read_bytes > 0 || zero_bytes > 0) {
-        /* Do calculate how to fill this page.
-         * We will read PAGE_READ_BYTES bytes from FILE
-         * and zero the final PAGE_ZERO_BYTES bytes. */
-        size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-        size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-        /* TODO: Set up aux to pass information to the lazy_load_segment. */
-        struct aux *aux = malloc(sizeof(struct aux)); // @todo 잊지말고 free하자!
-        if(aux == NULL)
-            return false;
-        aux->file = file;
-        aux->ofs = ofs;
-        aux->read_bytes = page_read_bytes;
-        aux->zero_bytes = page_zero_bytes; 
-        
-        if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux))
-            return false;
-
-        /* Advance. */
-        read_bytes -= page_read_bytes;
-        zero_bytes -= page_zero_bytes;
-        upage += PGSIZE;
-        ofs += page_read_bytes;
-    }
-    return true;
+    /* 세그먼트 전체를 VMA 하나로 등록합니다.
+     * 각 페이지는 처음 폴트가 날 때 lazy_load_segment로 읽어 옵니다. */
+    /* Register the whole segment as a single VMA.  Each page is
+     * read in by lazy_load_segment on its first fault. */
+    return vma_create(&thread_current()->spt, VMA_SEGMENT, upage, upage + read_bytes + zero_bytes, writable, file, ofs, read_bytes) != NULL;
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
@@ -934,6 +921,9 @@ static bool setup_stack(struct intr_frame *if_) {
      * TODO: You should mark the page is stack.
      * TODO: Your code goes here */
 
+    // 스택이 자랄 수 있는 범위 전체를 VMA로 등록해 둔다.
+    if (!vma_create(&thread_current()->spt, VMA_STACK, (void *)(USER_STACK - STACK_LIMIT), (void *)USER_STACK, true, NULL, 0, 0))
+        return false;
     if (!vm_alloc_page((VM_ANON | VM_MARKER_0), stack_bottom, true)) return false;
     if(vm_claim_page(stack_bottom)) {
         if_->rsp = USER_STACK;
@@ -2,8 +2,12 @@
 
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <string.h>
+#include <dirent.h>
+#include <uio.h>
 
 #include "devices/input.h"
+#include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "intrinsic.h"
@@ -11,11 +15,13 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "userprog/gdt.h"
 #include "userprog/process.h"
+#include "vm/stat.h"
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *f UNUSED);
@@ -38,6 +44,15 @@ void close(int fd);
 
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int vmstat (struct vm_stats *stats);
+int punch_hole (int fd, off_t offset, off_t length);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int sendfile (int out_fd, int in_fd, unsigned length);
+int getdents (int fd, struct dirent *buf, unsigned size);
 
 
 /* 시스템 호출.
@@ -111,7 +126,6 @@ void syscall_init(void) {
      * until the syscall_entry swaps the userland stack to the kernel
      * mode stack. Therefore, we masked the FLAG_FL. */
     write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-    lock_init(&filesys_lock);
 }
 
 /* 주요 시스템 호출 인터페이스 */
@@ -184,6 +198,42 @@ void syscall_handler(struct intr_frame *f UNUSED) {
             munmap(f->R.rdi);
             break;
 
+        case SYS_MSYNC:
+            f->R.rax = msync((void *) f->R.rdi, f->R.rsi);
+            break;
+
+        case SYS_VMSTAT:
+            f->R.rax = vmstat((struct vm_stats *) f->R.rdi);
+            break;
+
+        case SYS_PUNCH_HOLE:
+            f->R.rax = punch_hole(f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+
+        case SYS_PREAD:
+            f->R.rax = pread(f->R.rdi, (void *) f->R.rsi, f->R.rdx, f->R.r10);
+            break;
+
+        case SYS_PWRITE:
+            f->R.rax = pwrite(f->R.rdi, (const void *) f->R.rsi, f->R.rdx, f->R.r10);
+            break;
+
+        case SYS_READV:
+            f->R.rax = readv(f->R.rdi, (const struct iovec *) f->R.rsi, f->R.rdx);
+            break;
+
+        case SYS_WRITEV:
+            f->R.rax = writev(f->R.rdi, (const struct iovec *) f->R.rsi, f->R.rdx);
+            break;
+
+        case SYS_SENDFILE:
+            f->R.rax = sendfile(f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+
+        case SYS_GETDENTS:
+            f->R.rax = getdents(f->R.rdi, (struct dirent *) f->R.rsi, f->R.rdx);
+            break;
+
         default:
             exit(-1);
             break;
@@ -245,36 +295,25 @@ int wait(pid_t) {
 
 bool create(const char *file, unsigned initial_size) {
     check_address(file);
-    lock_acquire(&filesys_lock);
-    bool is_success = filesys_create(file, initial_size);
-    lock_release(&filesys_lock);
-    return is_success;
+    return filesys_create(file, initial_size);
 }
 
 bool remove(const char *file) {
     check_address(file);
-    lock_acquire(&filesys_lock);
-    bool is_success = filesys_remove(file);
-    lock_release(&filesys_lock);
-    return is_success;
+    return filesys_remove(file);
 }
 
 int open(const char *file) {
     check_address(file);
 
-    lock_acquire(&filesys_lock);
     struct file *f = filesys_open(file);
-
-    if (f == NULL) {
-        lock_release(&filesys_lock);
+    if (f == NULL)
         return -1;
-    }
 
     int fd = process_add_file(f);
     if (fd == -1)
         file_close(f);
 
-    lock_release(&filesys_lock);
     return fd;
 }
 
@@ -290,29 +329,26 @@ int read(int fd, void *buffer, unsigned size) {
     //@fixme : 버퍼가 쓰기 가능인지 체크하기
     check_address(buffer);
 
-    struct page *bf_page = spt_find_page(&thread_current()->spt, pg_round_down(buffer));
-    if (!bf_page->is_writable) {
+    // 버퍼 페이지가 아직 만들어지지 않았을 수 있으므로 VMA의 권한으로 판단한다.
+    struct vma *bf_vma = vma_find(&thread_current()->spt, buffer);
+    if (bf_vma != NULL && !bf_vma->writable) {
         exit(-1);
     }
        
     char *ptr = (char *)buffer;
     int bytes_read = 0;
 
-    lock_acquire(&filesys_lock);
+    // 파일 시스템은 inode마다 잠그므로 여기서는 전역 잠금을 잡지 않는다.
     if (fd == STDIN_FILENO) {
         for (int i = 0; i < size; i++) {
             *ptr++ = input_getc();
             bytes_read++;
         }
-        lock_release(&filesys_lock);
     } else {
         struct file *file = process_get_file(fd);
-        if (file == NULL) {
-            lock_release(&filesys_lock);
+        if (file == NULL)
             return -1;
-        }
         bytes_read = file_read(file, buffer, size);
-        lock_release(&filesys_lock);
     }
     return bytes_read;
 }
@@ -323,20 +359,15 @@ int write(int fd, const void *buffer, unsigned length) {
     char *ptr = (char *)buffer;
     int bytes_write = 0;
 
-    lock_acquire(&filesys_lock);
     if (fd == STDOUT_FILENO) {
         putbuf(buffer, length);
-        lock_release(&filesys_lock);
     }
 
     else {
         struct file *file = process_get_file(fd);
-        if (file == NULL) {
-            lock_release(&filesys_lock);
+        if (file == NULL)
             return -1;
-        }
         bytes_write = file_write(file, buffer, length);
-        lock_release(&filesys_lock);
     }
     return bytes_write;
 }
@@ -395,8 +426,8 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	}
 
 
-    // 이미 사용중인 주소였는지/페이지 였는지 (겹치지 않게)
-    if(spt_find_page(&thread_current()->spt, addr)) {
+    // 이미 사용중인 주소 범위와 겹치는지 (코드, 데이터, 스택, 다른 매핑 모두 VMA로 확인)
+    if (vma_overlaps(&thread_current()->spt, addr, pg_round_up(addr + length))) {
         return NULL;
     }
     
@@ -422,14 +453,243 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 }
 
 void munmap (void *addr) {
-    struct page *page = spt_find_page(&thread_current()->spt, addr);
-    size_t length = page->file.length;
-
-    size_t page_cnt = (length + PGSIZE - 1) / PGSIZE;
-    struct file *file = page->file.file;
-    for (size_t i = 0; i < page_cnt; i++) {
-        do_munmap(addr);
-        addr += PGSIZE;
+    do_munmap(addr);
+}
+
+int msync (void *addr, size_t length) {
+    // 페이지 정렬된 사용자 주소 범위만 허용한다. 주소 공간 끝을 넘어 돌아가는 범위도 거부한다.
+    if (addr == NULL || pg_ofs(addr) || (uintptr_t) addr + length < (uintptr_t) addr
+            || is_kernel_vaddr(addr) || is_kernel_vaddr(addr + length)) {
+        return -1;
     }
-    file_close(file);
+
+    void *end = addr + length;
+
+    // 범위의 모든 페이지가 파일 매핑 안에 있어야 한다. VMA는 겹치지 않으므로 하나씩 건너뛴다.
+    for (void *va = addr; va < end; ) {
+        struct vma *vma = vma_find(&thread_current()->spt, va);
+        if (vma == NULL || vma->kind != VMA_FILE) {
+            return -1;
+        }
+        va = vma->end;
+    }
+
+    do_msync(addr, length);
+    return 0;
+}
+
+int vmstat (struct vm_stats *stats) {
+    struct vm_stats snapshot;
+
+    check_address(stats);
+    check_address((uint8_t *)stats + sizeof *stats - 1);
+
+    // 스냅샷을 먼저 뜬 뒤 복사한다. 사용자 버퍼에서 폴트가 나면 통계가 바뀌기 때문이다.
+    vm_stat_get(&snapshot);
+    vm_rss_get(&snapshot);
+    memcpy(stats, &snapshot, sizeof snapshot);
+    return 0;
+}
+
+int punch_hole (int fd, off_t offset, off_t length) {
+    struct file *file = process_get_file(fd);
+    if (file == NULL || offset < 0 || length < 0)
+        return -1;
+
+    // 범위는 0으로 읽히고, 온전히 덮인 섹터는 디스크에서 해제된다.
+    return file_punch_hole(file, offset, length) ? 0 : -1;
+}
+
+// 사용자 버퍼 [BUFFER, BUFFER + SIZE)가 사용자 영역 안에 있으면 true를 반환한다.
+// WRITABLE이면 read처럼 VMA의 권한으로 쓰기 가능한지도 확인한다.
+static bool buffer_ok(const void *buffer, size_t size, bool writable) {
+    const uint8_t *last = (const uint8_t *)buffer + size - 1;
+
+    if (size == 0)
+        return true;
+    if (buffer == NULL || is_kernel_vaddr(buffer) || is_kernel_vaddr(last)
+            || last < (const uint8_t *)buffer)
+        return false;
+
+    if (writable) {
+        struct vma *vma = vma_find(&thread_current()->spt, buffer);
+        if (vma != NULL && !vma->writable)
+            return false;
+    }
+    return true;
+}
+
+static void check_buffer(const void *buffer, size_t size, bool writable) {
+    if (!buffer_ok(buffer, size, writable))
+        exit(-1);
+}
+
+int pread (int fd, void *buffer, unsigned length, off_t offset) {
+    check_buffer(buffer, length, true);
+
+    // 표준 입출력은 위치를 지정할 수 없다.
+    struct file *file = process_get_file(fd);
+    if (file == NULL || offset < 0)
+        return -1;
+
+    // 파일의 현재 위치는 바뀌지 않으므로 같은 fd로 여러 위치를 읽을 수 있다.
+    return file_read_at(file, buffer, length, offset);
+}
+
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset) {
+    check_buffer(buffer, length, false);
+
+    struct file *file = process_get_file(fd);
+    if (file == NULL || offset < 0)
+        return -1;
+
+    return file_write_at(file, buffer, length, offset);
+}
+
+// 사용자의 iovec 배열을 검사해 커널로 복사한다. 각 버퍼도 한 번에 모두 검사한다.
+// 실패하면 NULL을 반환하며, 잘못된 주소면 프로세스를 종료한다.
+static struct iovec *copy_in_iovec(const struct iovec *iov, int iovcnt, bool writable) {
+    if (iovcnt <= 0 || iovcnt > IOV_MAX)
+        return NULL;
+    check_buffer(iov, iovcnt * sizeof *iov, false);
+
+    struct iovec *kiov = malloc(iovcnt * sizeof *kiov);
+    if (kiov == NULL)
+        return NULL;
+    memcpy(kiov, iov, iovcnt * sizeof *kiov);
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        total += kiov[i].iov_len;
+        if (total < kiov[i].iov_len || total > INT32_MAX) {
+            free(kiov);
+            return NULL;
+        }
+    }
+
+    // 잘못된 버퍼가 있으면 복사본을 놓아 준 뒤 프로세스를 종료한다.
+    for (int i = 0; i < iovcnt; i++) {
+        if (!buffer_ok(kiov[i].iov_base, kiov[i].iov_len, writable)) {
+            free(kiov);
+            exit(-1);
+        }
+    }
+    return kiov;
+}
+
+int readv (int fd, const struct iovec *iov, int iovcnt) {
+    struct iovec *kiov = copy_in_iovec(iov, iovcnt, true);
+    if (kiov == NULL)
+        return -1;
+
+    struct file *file = process_get_file(fd);
+    int bytes_read = 0;
+
+    if (fd == STDIN_FILENO) {
+        for (int i = 0; i < iovcnt; i++) {
+            char *ptr = kiov[i].iov_base;
+            for (size_t j = 0; j < kiov[i].iov_len; j++)
+                *ptr++ = input_getc();
+            bytes_read += kiov[i].iov_len;
+        }
+    } else if (file == NULL) {
+        bytes_read = -1;
+    } else {
+        // 버퍼를 차례로 채우며, 파일 끝에 닿아 덜 읽히면 멈춘다.
+        for (int i = 0; i < iovcnt; i++) {
+            off_t n = file_read(file, kiov[i].iov_base, kiov[i].iov_len);
+            bytes_read += n;
+            if ((size_t)n < kiov[i].iov_len)
+                break;
+        }
+    }
+    free(kiov);
+    return bytes_read;
+}
+
+int writev (int fd, const struct iovec *iov, int iovcnt) {
+    struct iovec *kiov = copy_in_iovec(iov, iovcnt, false);
+    if (kiov == NULL)
+        return -1;
+
+    struct file *file = process_get_file(fd);
+    int bytes_write = 0;
+
+    if (fd == STDOUT_FILENO) {
+        for (int i = 0; i < iovcnt; i++) {
+            putbuf(kiov[i].iov_base, kiov[i].iov_len);
+            bytes_write += kiov[i].iov_len;
+        }
+    } else if (file == NULL) {
+        bytes_write = -1;
+    } else {
+        // 디스크가 가득 차서 덜 쓰이면 멈춘다.
+        for (int i = 0; i < iovcnt; i++) {
+            off_t n = file_write(file, kiov[i].iov_base, kiov[i].iov_len);
+            bytes_write += n;
+            if ((size_t)n < kiov[i].iov_len)
+                break;
+        }
+    }
+    free(kiov);
+    return bytes_write;
+}
+
+// sendfile의 출력 함수들. 버퍼 캐시의 데이터를 받아 파일이나 콘솔로 바로 쓴다.
+static off_t send_to_file(void *file, const void *buffer, off_t size) {
+    return file_write(file, buffer, size);
+}
+
+static off_t send_to_console(void *aux UNUSED, const void *buffer, off_t size) {
+    putbuf(buffer, size);
+    return size;
+}
+
+int sendfile (int out_fd, int in_fd, unsigned length) {
+    struct file *in = process_get_file(in_fd);
+    if (in == NULL || (int)length < 0)
+        return -1;
+
+    // 사용자 버퍼를 거치지 않고 in_fd의 현재 위치부터 out_fd로 옮긴다.
+    if (out_fd == STDOUT_FILENO)
+        return file_transfer(in, length, send_to_console, NULL);
+
+    struct file *out = process_get_file(out_fd);
+    if (out == NULL)
+        return -1;
+    return file_transfer(in, length, send_to_file, out);
+}
+
+int getdents (int fd, struct dirent *buf, unsigned size) {
+    check_buffer(buf, size, true);
+
+    struct file *file = process_get_file(fd);
+    if (file == NULL || !inode_is_dir(file_get_inode(file)))
+        return -1;
+
+    // 디렉토리의 읽기 위치는 fd의 파일 위치에 기억해 둔다.
+    struct dir *dir = dir_open(inode_reopen(file_get_inode(file)));
+    struct dirent *ents = palloc_get_page(0);
+    if (dir == NULL || ents == NULL) {
+        dir_close(dir);
+        palloc_free_page(ents);
+        return -1;
+    }
+    dir_seek(dir, file_tell(file));
+
+    // 블록 단위로 한 페이지씩 모아 사용자 버퍼로 복사한다. 복사 중에는 잠금을 잡지 않는다.
+    size_t max = size / sizeof *ents, cnt = 0;
+    while (cnt < max) {
+        size_t want = max - cnt < PGSIZE / sizeof *ents ? max - cnt : PGSIZE / sizeof *ents;
+        size_t n = dir_getdents(dir, ents, want);
+        if (n == 0)
+            break;
+        memcpy(buf + cnt, ents, n * sizeof *ents);
+        cnt += n;
+    }
+    file_seek(file, dir_tell(dir));
+
+    dir_close(dir);
+    palloc_free_page(ents);
+    return cnt * sizeof *ents;
 }
@@ -2,9 +2,14 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include "vm/stat.h"
 #include "devices/disk.h"
+#ifdef FILESYS
+#include "filesys/filesys.h"
+#endif
 
 #include <bitmap.h>
+#include <string.h>
 
 #include "threads/mmu.h"
 
@@ -34,6 +39,11 @@ vm_anon_init (void) {
 	/* 할 일: 스왑 디스크를 설정하세요. */
 	/* TODO: Set up the swap_disk. */
 	swap_disk = disk_get(1, 1);
+#ifdef FILESYS
+	// -stripe로 hd1:1이 스트라이프에 들어가면 스왑은 그 뒤쪽 절반을 쓴다.
+	if (filesys_swap_disk != NULL)
+		swap_disk = filesys_swap_disk;
+#endif
 	swap_table = bitmap_create(disk_size(swap_disk) / 8); // 디스크는 섹터(512바이트) 단위로 관리함 그래서 8 섹터가 있어야 하나의 페이지를 저장가능
 	lock_init(&bitmap_lock);
 }
@@ -67,9 +77,8 @@ anon_swap_in (struct page *page, void *kva) {
 		return false;
 	}
 
-	for (int i = 0; i < 8; i++) {
-		disk_read(swap_disk, swap_idx * 8 + i, kva + i * DISK_SECTOR_SIZE);
-	}
+	disk_read_multiple(swap_disk, swap_idx * 8, 8, kva);
+	vm_stat_event(VME_SWAP_READ);
 
 	page->frame->kva = kva;
 
@@ -87,22 +96,60 @@ anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
 
 	lock_acquire(&bitmap_lock);
-	size_t swap_idx = bitmap_scan_and_flip(swap_table, 0, 1, false);
+	size_t swap_idx = bitmap_find_first(swap_table, 0, false);
+	if (swap_idx != BITMAP_ERROR)
+		bitmap_mark(swap_table, swap_idx);
 	lock_release(&bitmap_lock);
 	if (swap_idx == BITMAP_ERROR) {
 		return false;
 	}
 	anon_page->swap_idx = swap_idx;
 
-	for (int i = 0; i < 8; i++) {
-		disk_write(swap_disk, swap_idx * 8 + i, page->frame->kva + DISK_SECTOR_SIZE * i);
-	}
+	disk_write_multiple(swap_disk, swap_idx * 8, 8, page->frame->kva);
+	vm_stat_event(VME_SWAP_WRITE);
 
+	/* 다른 프로세스의 페이지가 교체될 수도 있으므로 소유자의 pml4에서 지웁니다. */
+	uint64_t *pml4 = page->frame->thread->pml4;
 	page->frame->page = NULL;
 	page->frame = NULL;
 	
 	
-	pml4_clear_page(thread_current()->pml4, page->va);
+	pml4_clear_page(pml4, page->va);
+	return true;
+}
+
+/* PAGE의 내용을 KVA로 복사합니다. PAGE가 스왑 아웃되어 있으면 스왑 슬롯을 해제하지 않고
+ * 그대로 읽습니다. 복사하는 동안 프레임을 고정해서 교체되지 않도록 합니다. */
+/* Copies the contents of anonymous PAGE, which may belong to
+ * another process, into KVA.  A swapped-out PAGE is read from its
+ * swap slot, which stays allocated.  A resident PAGE has its frame
+ * pinned while it is copied.  Returns false if PAGE has no
+ * contents to copy. */
+bool
+anon_copy_contents (struct page *page, void *kva) {
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	while (page->frame != NULL && page->frame->pinned)
+		cond_wait(&frames_unpinned, &frame_lock);
+	frame = page->frame;
+	if (frame != NULL)
+		frame->pinned = true;
+	lock_release(&frame_lock);
+
+	if (frame == NULL) {
+		if (page->anon.swap_idx == BITMAP_ERROR)
+			return false;
+		disk_read_multiple(swap_disk, page->anon.swap_idx * 8, 8, kva);
+		vm_stat_event(VME_SWAP_READ);
+		return true;
+	}
+
+	memcpy(kva, frame->kva, PGSIZE);
+	lock_acquire(&frame_lock);
+	frame->pinned = false;
+	cond_broadcast(&frames_unpinned, &frame_lock);
+	lock_release(&frame_lock);
 	return true;
 }
 
@@ -112,21 +159,29 @@ static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
 	
-	// 스왑 테이블에서 스왑 인덱스 해제
-	if (anon_page->swap_idx != BITMAP_ERROR) {
-		lock_acquire(&bitmap_lock);
-		bitmap_reset(swap_table, anon_page->swap_idx);
-		lock_release(&bitmap_lock);
-	}
-
 	// 프레임이 존재하면 프레임을 리스트에서 제거하고 해제
-	if (page->frame) {
+	lock_acquire(&frame_lock);
+	/* 다른 스레드가 복사하거나 교체하는 중이면 끝날 때까지 기다립니다. */
+	while (page->frame != NULL && page->frame->pinned)
+		cond_wait(&frames_unpinned, &frame_lock);
+	if (page->frame == NULL)
+		lock_release(&frame_lock);
+	else {
 		list_remove(&page->frame->elem);
+		page->frame->thread->spt.rss--;
+		lock_release(&frame_lock);
 		page->frame->page = NULL;
 		palloc_free_page(page->frame->kva);
 		free(page->frame);
 		page->frame = NULL;
 	}
 
+	// 스왑 테이블에서 스왑 인덱스 해제
+	if (anon_page->swap_idx != BITMAP_ERROR) {
+		lock_acquire(&bitmap_lock);
+		bitmap_reset(swap_table, anon_page->swap_idx);
+		lock_release(&bitmap_lock);
+	}
+
 	pml4_clear_page(thread_current()->pml4, page->va);
 }
@@ -2,15 +2,51 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include "vm/stat.h"
 #include "threads/vaddr.h"
 
 #include "userprog/process.h"
 #include "threads/mmu.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+#include <round.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 플러셔가 한 번에 모아서 정렬해 쓰는 최대 페이지 수 */
+/* Maximum number of pages the flusher sorts and writes at once. */
+#define FLUSH_BATCH 64
+/* 한 번의 쓰기로 합치는 최대 페이지 수 */
+/* Most adjacent pages merged into a single write. */
+#define FLUSH_RUN 8
+/* 플러셔가 깨어나는 주기 (틱) */
+/* How often the flusher wakes up, in timer ticks. */
+#define FLUSH_INTERVAL TIMER_FREQ
+
+/* 쓰기 대기 중인 더러운 페이지 하나. 프레임은 쓰기가 끝날 때까지 고정됩니다. */
+/* One dirty page waiting to be written back.  Its frame stays
+ * pinned until the write is done. */
+struct flush_entry {
+	disk_sector_t inumber;      /* 파일의 inode 번호 / Inode number of the file. */
+	off_t ofs;                  /* 파일 내 오프셋 / Offset within the file. */
+	struct file *file;          /* 쓸 파일 / File to write to. */
+	uint32_t bytes;             /* 쓸 바이트 수 / Bytes to write. */
+	struct frame *frame;        /* 고정된 프레임 / Pinned frame. */
+};
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
+static void file_backed_writeback (struct page *page);
+static size_t flush_add (struct flush_entry *batch, size_t cnt,
+		struct page *page);
+static void flush_batch (struct flush_entry *batch, size_t cnt,
+		uint8_t *bounce);
+static void file_flusher (void *aux UNUSED);
+static void msync_range (struct supplemental_page_table *spt, void *addr,
+		void *end);
 
 /* 이 구조체를 수정하지 마세요 */
 /* DO NOT MODIFY this struct */
@@ -25,6 +61,8 @@ static const struct page_operations file_ops = {
 /* The initializer of file vm */
 void
 vm_file_init (void) {
+	/* 더러운 파일 페이지를 주기적으로 되돌려 쓰는 플러셔를 시작합니다. */
+	thread_create ("file_flusher", PRI_MIN, file_flusher, NULL);
 }
 
 /* 파일 지원 페이지 초기화 */
@@ -43,7 +81,6 @@ file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
 	file_page->ofs = aux->ofs;
 	file_page->page_read_bytes = aux->read_bytes;
 	file_page->page_zero_bytes = aux->zero_bytes;
-	file_page->length = aux->length;
 
 	return true;
 }
@@ -56,6 +93,7 @@ file_backed_swap_in (struct page *page, void *kva) {
 
 
 	file_read_at (file_page->file, kva, file_page->page_read_bytes, file_page->ofs);
+	vm_stat_event (VME_FILE_READ);
 
 	return true;
 }
@@ -64,16 +102,14 @@ file_backed_swap_in (struct page *page, void *kva) {
 /* Swap out the page by writeback contents to the file. */
 static bool
 file_backed_swap_out (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	/* 플러셔가 미리 써 두었다면 깨끗한 페이지이므로 쓰기 없이 바로 내보냅니다. */
+	uint64_t *pml4 = page->frame->thread->pml4;
+	file_backed_writeback(page);
 
-	if (pml4_is_dirty(thread_current()->pml4, page->va) && page->is_writable) {
-		file_write_at(file_page->file, page->va, file_page->page_read_bytes, file_page->ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, false);
-	}
 	// list_remove(&page->frame->elem);
 	page->frame->page = NULL;
 	page->frame = NULL;
-	pml4_clear_page(thread_current()->pml4, page->va);
+	pml4_clear_page(pml4, page->va);
 
 	return true;
 }
@@ -82,80 +118,287 @@ file_backed_swap_out (struct page *page) {
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	lock_acquire(&frame_lock);
+	/* 플러셔가 이 프레임에서 쓰는 중이거나 교체하는 중이면 끝날 때까지 기다립니다. */
+	while (page->frame != NULL && page->frame->pinned)
+		cond_wait(&frames_unpinned, &frame_lock);
+	if (page->frame == NULL)
+		lock_release(&frame_lock);
+	else {
+		list_remove(&page->frame->elem);
+		page->frame->thread->spt.rss--;
+		lock_release(&frame_lock);
 
-	if (pml4_is_dirty(thread_current()->pml4, page->va) && page->is_writable) {
-		file_write_at(file_page->file, page->va, file_page->page_read_bytes, file_page->ofs);
-		pml4_set_dirty(thread_current()->pml4, page->va, false); // @todo: 어차피 클리어 해줄건데 왜필요함?
-	}
+		file_backed_writeback(page);
 
-	if (page->frame) {
-		list_remove(&page->frame->elem);
-		page->frame->page = NULL;
-		page->frame = NULL;
+		pml4_clear_page(thread_current()->pml4, page->va);
+		palloc_free_page(page->frame->kva);
 		free(page->frame);
+		page->frame = NULL;
 	}
 
 
 	pml4_clear_page(thread_current()->pml4, page->va);
 }
 
-/* mmap을 실행하세요 */
-/* Do the mmap */
+/* 페이지가 더럽다면 파일에 되돌려 씁니다.
+ * 쓰기 전에 dirty 비트를 먼저 지워서, 쓰는 도중의 수정은 다음 번에 다시 쓰이도록 합니다.
+ * 페이지는 프레임을 가지고 있어야 합니다. */
+/* Writes PAGE back to its file if it is dirty.  The dirty bit is
+ * cleared before the write, so that a store racing with the write
+ * marks the page dirty again.  PAGE must have a frame. */
+static void
+file_backed_writeback (struct page *page) {
+	struct file_page *file_page = &page->file;
+	uint64_t *pml4 = page->frame->thread->pml4;
+
+	if (!page->is_writable || !pml4_is_dirty (pml4, page->va))
+		return;
+
+	pml4_set_dirty (pml4, page->va, false);
+	file_write_at (file_page->file, page->frame->kva,
+			file_page->page_read_bytes, file_page->ofs);
+	vm_stat_event (VME_FILE_WRITE);
+}
+
+/* 파일 위치 순으로 정렬합니다. */
+/* Orders flush entries by file, then by offset. */
+static int
+flush_entry_compare (const void *a_, const void *b_) {
+	const struct flush_entry *a = a_;
+	const struct flush_entry *b = b_;
+
+	if (a->inumber != b->inumber)
+		return a->inumber < b->inumber ? -1 : 1;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs ? -1 : 1;
+	return 0;
+}
+
+/* PAGE가 더러운 파일 페이지라면 dirty 비트를 지우고 프레임을 고정한 뒤 BATCH에 추가합니다.
+ * BATCH에 든 페이지 수를 반환합니다. frame_lock을 잡은 상태여야 하며, BATCH에는
+ * FLUSH_BATCH보다 적은 페이지가 있어야 합니다. */
+/* Appends PAGE to BATCH if it is a dirty, resident file page.  Its
+ * dirty bit is cleared, so that a store racing with the write
+ * marks the page dirty again, and its frame is pinned so that it
+ * is neither evicted nor freed before the write is done.  Returns
+ * the new number of entries in BATCH, which must have room for
+ * one more.  frame_lock must be held. */
+static size_t
+flush_add (struct flush_entry *batch, size_t cnt, struct page *page) {
+	ASSERT (cnt < FLUSH_BATCH);
+
+	if (page == NULL || page->frame == NULL || page->frame->pinned
+			|| page->operations->type != VM_FILE || !page->is_writable
+			|| !pml4_is_dirty (page->frame->thread->pml4, page->va))
+		return cnt;
+
+	pml4_set_dirty (page->frame->thread->pml4, page->va, false);
+	page->frame->pinned = true;
+	batch[cnt].inumber = inode_get_inumber (file_get_inode (page->file.file));
+	batch[cnt].ofs = page->file.ofs;
+	batch[cnt].file = page->file.file;
+	batch[cnt].bytes = page->file.page_read_bytes;
+	batch[cnt].frame = page->frame;
+	return cnt + 1;
+}
+
+/* BATCH[I] 바로 뒤에 같은 파일에서 이어지는 페이지가 BATCH[I + 1]에 있으면 true를 반환합니다. */
+/* Returns true if BATCH[I + 1] continues BATCH[I] in the same
+ * file, so that the two can be written as one. */
+static bool
+flush_adjacent (const struct flush_entry *batch, size_t i) {
+	return batch[i].inumber == batch[i + 1].inumber
+		&& batch[i].bytes == PGSIZE
+		&& batch[i].ofs + PGSIZE == batch[i + 1].ofs;
+}
+
+/* frame_lock 없이 BATCH의 페이지들을 파일과 오프셋 순으로 정렬해서 쓰고, 프레임들의 고정을 풉니다.
+ * 같은 파일에서 이어지는 페이지들은 BOUNCE로 모아 한 번에 씁니다. BOUNCE는 FLUSH_RUN 페이지
+ * 크기이며, NULL이면 페이지마다 따로 씁니다. */
+/* Sorts the pages in BATCH by file and offset, writes them back,
+ * and unpins their frames.  Must be called without frame_lock, so
+ * that faults and evictions go on during the writes.  Runs of
+ * adjacent pages of one file are gathered into BOUNCE, FLUSH_RUN
+ * pages long, and written with a single call; if BOUNCE is null,
+ * each page is written by itself. */
+static void
+flush_batch (struct flush_entry *batch, size_t cnt, uint8_t *bounce) {
+	size_t i, j;
+
+	qsort (batch, cnt, sizeof *batch, flush_entry_compare);
+	for (i = 0; i < cnt; i = j) {
+		size_t run = 1;
+		uint32_t bytes;
+
+		while (bounce != NULL && run < FLUSH_RUN && i + run < cnt
+				&& flush_adjacent (batch, i + run - 1))
+			run++;
+		j = i + run;
+
+		if (run == 1) {
+			file_write_at (batch[i].file, batch[i].frame->kva, batch[i].bytes,
+					batch[i].ofs);
+			vm_stat_event (VME_FILE_WRITE);
+			continue;
+		}
+		for (size_t k = i; k < j; k++)
+			memcpy (bounce + (k - i) * PGSIZE, batch[k].frame->kva, PGSIZE);
+		bytes = (run - 1) * PGSIZE + batch[j - 1].bytes;
+		file_write_at (batch[i].file, bounce, bytes, batch[i].ofs);
+		for (size_t k = i; k < j; k++)
+			vm_stat_event (VME_FILE_WRITE);
+	}
+
+	lock_acquire (&frame_lock);
+	for (i = 0; i < cnt; i++)
+		batch[i].frame->pinned = false;
+	cond_broadcast (&frames_unpinned, &frame_lock);
+	lock_release (&frame_lock);
+}
+
+/* 주기적으로 프레임 테이블을 훑어 더러운 파일 페이지를 되돌려 쓰는 커널 스레드.
+ * 덕분에 깨끗한 페이지의 교체는 쓰기가 필요 없고, munmap과 exit도 쓰기 폭주로 멈추지 않습니다.
+ * frame_lock은 더러운 페이지를 모으는 동안만 잡습니다. */
+/* Kernel thread that periodically scans the frame table and
+ * writes dirty file pages back.  Evicting a clean page is then
+ * free, and munmap and exit no longer stall on a burst of
+ * writes.  frame_lock is only held while collecting a batch, not
+ * during the writes. */
+static void
+file_flusher (void *aux UNUSED) {
+	static struct flush_entry batch[FLUSH_BATCH];
+	uint8_t *bounce = palloc_get_multiple (0, FLUSH_RUN);
+
+	for (;;) {
+		size_t cnt;
+
+		timer_sleep (FLUSH_INTERVAL);
+
+		/* 모은 페이지는 깨끗해지므로, 배치가 가득 찼으면 처음부터 다시 훑어 나머지를 모읍니다. */
+		/* Collected pages are clean afterward, so a full batch is
+		 * followed by another scan that picks up the rest. */
+		do {
+			cnt = 0;
+			lock_acquire (&frame_lock);
+			for (struct list_elem *e = list_begin (&frame_table);
+					e != list_end (&frame_table) && cnt < FLUSH_BATCH;
+					e = list_next (e)) {
+				struct frame *frame = list_entry (e, struct frame, elem);
+				cnt = flush_add (batch, cnt, frame->page);
+			}
+			lock_release (&frame_lock);
+			flush_batch (batch, cnt, bounce);
+		} while (cnt == FLUSH_BATCH);
+	}
+}
+
+/* msync를 실행하세요
+ * [ADDR, ADDR + LENGTH)에 있는 더러운 파일 페이지들을 바로 되돌려 씁니다. */
+/* Do the msync.
+ * Writes the dirty file pages in [ADDR, ADDR + LENGTH) back
+ * immediately. */
+void
+do_msync (void *addr, size_t length) {
+	msync_range (&thread_current ()->spt, addr, addr + length);
+}
+
+/* SPT의 더러운 파일 페이지를 모두 되돌려 씁니다. fork 중인 부모처럼 SPT의 주인이
+ * 페이지를 제거하지 않는 동안에는 다른 스레드가 불러도 됩니다. */
+/* Writes every dirty file page of SPT back.  May be called from
+ * another thread while the owner of SPT is blocked and cannot
+ * remove its pages, as a parent in fork is. */
+void
+do_msync_all (struct supplemental_page_table *spt) {
+	msync_range (spt, NULL, (void *) KERN_BASE);
+}
+
+/* SPT에서 [ADDR, END)에 있는 더러운 파일 페이지들을 되돌려 씁니다. */
+/* Writes the dirty file pages of SPT in [ADDR, END) back. */
+static void
+msync_range (struct supplemental_page_table *spt, void *addr, void *end) {
+	struct flush_entry *batch = malloc (sizeof *batch * FLUSH_BATCH);
+	uint8_t *bounce = palloc_get_multiple (0, FLUSH_RUN);
+	size_t cnt;
+
+	if (batch == NULL) {
+		if (bounce != NULL)
+			palloc_free_multiple (bounce, FLUSH_RUN);
+		return;
+	}
+
+	/* 이 프로세스의 페이지는 이 스레드만 제거하므로 VMA와 페이지 리스트는 잠금 없이도
+	 * 바뀌지 않습니다. */
+	/* Only this thread removes its own pages, so the VMAs and their
+	 * page lists stay put between batches. */
+	do {
+		cnt = 0;
+		lock_acquire (&frame_lock);
+		for (struct vma *vma = vma_first_in (spt, addr, end);
+				vma != NULL && vma->start < end && cnt < FLUSH_BATCH;
+				vma = vma_next (vma)) {
+			if (vma->kind != VMA_FILE)
+				continue;
+			for (struct list_elem *e = list_begin (&vma->pages);
+					e != list_end (&vma->pages) && cnt < FLUSH_BATCH;
+					e = list_next (e)) {
+				struct page *page = list_entry (e, struct page, vma_elem);
+				if (addr <= page->va && page->va < end)
+					cnt = flush_add (batch, cnt, page);
+			}
+		}
+		lock_release (&frame_lock);
+		flush_batch (batch, cnt, bounce);
+	} while (cnt == FLUSH_BATCH);
+
+	if (bounce != NULL)
+		palloc_free_multiple (bounce, FLUSH_RUN);
+	free (batch);
+}
+
+/* mmap을 실행하세요
+ * 페이지를 하나씩 만들지 않고 VMA 하나만 등록합니다. 페이지는 폴트가 날 때 만들어집니다. */
+/* Do the mmap.
+ * Only a single VMA is registered; its pages are created on
+ * fault. */
 void *
 do_mmap (void *addr, size_t length, int writable,
 		struct file *file, off_t offset) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
 
-	void * upage = addr;
-	size_t read_bytes = length;	//@todo: 만약 파일 길이보다 더 길게 요청했다면??
-	size_t zero_bytes = PGSIZE - read_bytes % PGSIZE;
-	off_t ofs = offset;
-
-	lock_acquire(&filesys_lock);
 	file = file_reopen(file);
-	lock_release(&filesys_lock);
 	if (file == NULL) {
 		return NULL;
 	}
-	
-	// ASSERT((read_bytes + zero_bytes) % PGSIZE == 0);
-	// ASSERT(pg_ofs(addr) == 0);
-	// ASSERT(offset % PGSIZE == 0);
-
-	while (read_bytes > 0 || zero_bytes > 0) {
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-
-		struct aux *aux = malloc(sizeof(struct aux)); // @todo 잊지말고 free하자!
-		if(aux == NULL)
-			return false;
-		aux->file = file;
-		aux->ofs = ofs;
-		aux->read_bytes = page_read_bytes;
-		aux->zero_bytes = page_zero_bytes;
-		aux->length = length; //VM_FILE 전체 페이지 확인용
-		
-		if (!vm_alloc_page_with_initializer(VM_FILE, upage, writable, lazy_load_segment, aux)) {
-			free(aux);
-			return NULL;
-		}
 
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-		ofs += page_read_bytes;
+	/* 파일 끝을 넘어가는 부분은 0으로 채웁니다. */
+	size_t read_bytes = length;
+	off_t file_left = file_length (file) - offset;
+	if (file_left < 0)
+		file_left = 0;
+	if (read_bytes > (size_t) file_left)
+		read_bytes = file_left;
+
+	if (vma_create (spt, VMA_FILE, addr, addr + ROUND_UP (length, PGSIZE),
+				writable, file, offset, read_bytes) == NULL) {
+		file_close (file);
+		return NULL;
 	}
-	// @todo lock 생각하기
 
 	return addr;
 }
 
-/* munmap을 실행하세요 */
-/* Do the munmap */
+/* munmap을 실행하세요
+ * ADDR에서 시작하는 매핑 전체와 그 안에서 만들어진 페이지들을 제거합니다. */
+/* Do the munmap.
+ * Removes the whole mapping that starts at ADDR, along with the
+ * pages materialized inside it. */
 void
 do_munmap (void *addr) {
-	struct page *page;
-	page = spt_find_page(&thread_current()->spt, addr);
-	spt_remove_page(&thread_current()->spt, page);
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct vma *vma = vma_find (spt, addr);
+
+	if (vma == NULL || vma->kind != VMA_FILE || vma->start != addr)
+		return;
+	vma_destroy (spt, vma);
 }
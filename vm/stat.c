@@ -0,0 +1,127 @@
+/* stat.c: 가상 메모리 계측.
+ * 폴트 종류별 횟수, 교체와 스왑 같은 사건 수, 그리고 TSC로 잰
+ * 주요 구간의 지연 시간 히스토그램을 모읍니다. */
+/* stat.c: Virtual memory instrumentation.
+ *
+ * Counts page faults by kind and events such as evictions and
+ * swap I/O, and keeps log2 histograms of the TSC cycles spent in
+ * the main paging operations. */
+
+#include "vm/stat.h"
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
+#include "threads/interrupt.h"
+
+static struct vm_stats vm_stats;
+
+static const char *fault_names[VMF_CNT] = {
+	"stack growth", "lazy load", "swap in", "file in", "bad",
+};
+static const char *event_names[VME_CNT] = {
+	"evict", "swap read", "swap write", "file read", "file write",
+	"zero fill",
+};
+static const char *timer_names[VMT_CNT] = {
+	"claim", "swap_in", "swap_out", "uninit_initialize",
+};
+
+/* KIND 폴트를 하나 셉니다. */
+/* Counts one fault of KIND. */
+void
+vm_stat_fault (enum vm_fault_kind kind) {
+	enum intr_level old_level = intr_disable ();
+	vm_stats.faults[kind]++;
+	intr_set_level (old_level);
+}
+
+/* EVENT를 하나 셉니다. */
+/* Counts one EVENT. */
+void
+vm_stat_event (enum vm_event event) {
+	enum intr_level old_level = intr_disable ();
+	vm_stats.events[event]++;
+	intr_set_level (old_level);
+}
+
+/* 잴 구간의 시작 시각을 반환합니다. vm_stat_stop에 넘기세요. */
+/* Returns the start time of a timed operation, to be passed to
+ * vm_stat_stop. */
+uint64_t
+vm_stat_start (void) {
+	return rdtsc ();
+}
+
+/* START부터 지금까지 걸린 사이클을 TIMER의 히스토그램에 넣습니다. */
+/* Records the cycles elapsed since START in the histogram of
+ * TIMER. */
+void
+vm_stat_stop (enum vm_timer timer, uint64_t start) {
+	uint64_t cycles = rdtsc () - start;
+	int bucket = cycles != 0 ? 63 - __builtin_clzll (cycles) : 0;
+
+	if (bucket >= VM_HIST_BUCKETS)
+		bucket = VM_HIST_BUCKETS - 1;
+
+	enum intr_level old_level = intr_disable ();
+	vm_stats.cycles[timer] += cycles;
+	vm_stats.hist[timer][bucket]++;
+	intr_set_level (old_level);
+}
+
+/* 현재 통계를 STATS에 복사합니다. */
+/* Copies a consistent snapshot of the statistics into STATS. */
+void
+vm_stat_get (struct vm_stats *stats) {
+	enum intr_level old_level = intr_disable ();
+	memcpy (stats, &vm_stats, sizeof *stats);
+	intr_set_level (old_level);
+}
+
+/* HIST에서 전체의 PERMILLE/1000 이상을 덮는 가장 작은 칸의 상한을 반환합니다. */
+/* Returns the upper bound, in cycles, of the lowest bucket of
+ * HIST at or below which PERMILLE/1000 of the samples fall. */
+static uint64_t
+hist_percentile (const uint64_t *hist, uint64_t total, int permille) {
+	uint64_t want = (total * permille + 999) / 1000;
+	uint64_t seen = 0;
+	int i;
+
+	for (i = 0; i < VM_HIST_BUCKETS - 1; i++) {
+		seen += hist[i];
+		if (seen >= want)
+			break;
+	}
+	return 1ULL << (i + 1);
+}
+
+/* 통계를 콘솔에 출력합니다. */
+/* Prints the statistics to the console. */
+void
+vm_stat_print (void) {
+	struct vm_stats s;
+	int i, b;
+
+	vm_stat_get (&s);
+
+	printf ("Page faults:");
+	for (i = 0; i < VMF_CNT; i++)
+		printf ("%s %llu %s", i ? "," : "", s.faults[i], fault_names[i]);
+	printf ("\nPaging events:");
+	for (i = 0; i < VME_CNT; i++)
+		printf ("%s %llu %s", i ? "," : "", s.events[i], event_names[i]);
+	printf ("\n");
+
+	for (i = 0; i < VMT_CNT; i++) {
+		uint64_t total = 0;
+		for (b = 0; b < VM_HIST_BUCKETS; b++)
+			total += s.hist[i][b];
+		if (total == 0)
+			continue;
+
+		printf ("  %s: %llu calls, avg %llu cycles, p50 < %llu, p99 < %llu\n",
+				timer_names[i], total, s.cycles[i] / total,
+				hist_percentile (s.hist[i], total, 500),
+				hist_percentile (s.hist[i], total, 990));
+	}
+}
@@ -16,6 +16,7 @@
 
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include "vm/stat.h"
 
 static bool uninit_initialize (struct page *page, void *kva);
 static void uninit_destroy (struct page *page);
@@ -61,6 +62,10 @@ uninit_initialize (struct page *page, void *kva) {
 	vm_initializer *init = uninit->init;
 	void *aux = uninit->aux;
 
+	/* 내용을 채울 초기화 함수가 없으면 0으로만 채워진 페이지입니다. */
+	if (init == NULL)
+		vm_stat_event (VME_ZERO_FILL);
+
 	/* TODO: 이 함수를 수정해야 할 수도 있습니다. */
 	/* TODO: You may need to fix this function. */
 	return uninit->page_initializer (page, uninit->type, kva) &&
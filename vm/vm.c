@@ -4,13 +4,38 @@
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "vm/stat.h"
 
 #include "threads/vaddr.h"
 #include "threads/mmu.h"
+#include "devices/timer.h"
+#include <stdio.h>
+#include <string.h>
+
+/* 작업 집합을 추정하는 주기 (틱) */
+/* How often working sets are sampled, in timer ticks. */
+#define WSS_INTERVAL TIMER_FREQ
+
+/* 보조 페이지 테이블의 첫 크기 (슬롯 수, 2의 거듭제곱) */
+/* Initial number of slots in a supplemental page table. */
+#define SPT_MIN_CAPACITY 64
 
 
 /* 프레임 테이블 */
 struct list frame_table;
+/* 프레임 테이블 락. 프레임 테이블의 원소를 넣고 뺄 때 잡습니다. */
+struct lock frame_lock;
+/* 고정한 프레임을 풀 때 알립니다. frame_lock과 함께 씁니다. */
+struct condition frames_unpinned;
+
+/* 프로세스 하나의 기본 RSS 제한. -rss 옵션으로 정합니다. */
+size_t vm_rss_limit;
+
+/* 교체 통계 */
+static size_t global_evict_cnt;     /* 전역 교체 횟수 */
+static size_t local_evict_cnt;      /* RSS 제한으로 인한 자기 교체 횟수 */
+
+static void vm_wss_sampler (void *aux UNUSED);
 
 /* 각 하위 시스템의 초기화 코드를 호출하여 가상 메모리 하위 시스템을 초기화합니다. */
 /* Initializes the virtual memory subsystem by invoking each subsystem's
@@ -21,12 +46,13 @@ vm_init (void) {
 	vm_anon_init ();
 	vm_file_init ();
 	list_init(&frame_table);
-#ifdef EFILESYS  /* For project 4 */
+	lock_init(&frame_lock);
+	cond_init(&frames_unpinned);
 	pagecache_init ();
-#endif
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */ 
 	/* TODO: Your code goes here. */
+	thread_create ("vm_wss", PRI_MIN, vm_wss_sampler, NULL);
 }
 
 /* 페이지의 유형을 가져옵니다. 이 함수는 페이지가 초기화된 후의 유형을 알고 싶을 때 유용합니다.
@@ -47,14 +73,14 @@ page_get_type (struct page *page) {
 
 /* 도우미 함수들 */
 /* Helpers */
-static struct frame *vm_get_victim (void);
+static struct frame *vm_get_victim (struct thread *owner);
 static bool vm_do_claim_page (struct page *page);
-static struct frame *vm_evict_frame (void);
+static struct frame *vm_evict_frame (struct thread *owner);
 
-/* 해시 도우미 함수들 */
-unsigned page_hash (const struct hash_elem *p_, void *aux UNUSED);
-bool page_less (const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
-void page_destructor (struct hash_elem *page_elem, void *aux UNUSED);
+/* 보조 페이지 테이블 도우미 함수들 */
+static struct spt_slot *spt_probe (struct supplemental_page_table *spt, uintptr_t vpn);
+static bool spt_grow (struct supplemental_page_table *spt);
+static void spt_delete (struct supplemental_page_table *spt, struct page *page);
 		   
 
 /* 초기화기와 함께 대기 중인 페이지 객체를 생성합니다. 페이지를 생성하려면 직접 생성하지 말고 이 함수나 vm_alloc_page를 통해 만드세요. */
@@ -109,7 +135,13 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		
 		page->is_writable = writable;
 
-		if(spt_insert_page(spt, page)) return true;
+		if(spt_insert_page(spt, page)) {
+			/* 페이지를 덮는 VMA에 연결해 munmap 때 함께 제거되도록 합니다. */
+			page->vma = vma_find(spt, upage);
+			if (page->vma != NULL)
+				list_push_back(&page->vma->pages, &page->vma_elem);
+			return true;
+		}
 	}
 err:
 	free(aux);  //@todo: free 맞는지 고민하기
@@ -120,18 +152,18 @@ err:
 /* Find VA from spt and return page. On error, return NULL. */
 struct page *
 spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-	struct page page;
-	struct hash_elem *elem;
-	va = pg_round_down(va);
-	page.va = va;
-	
-	elem = hash_find(&spt->hash_pages, &page.hash_elem);
-
-	if (elem != NULL) {
-		return hash_entry (elem, struct page, hash_elem);
-	}
-
-	return NULL;
+	uintptr_t vpn = pg_no(va);
+
+	/* 폴트와 시스템 호출 버퍼 검사는 같은 페이지를 연달아 찾는 경우가 많습니다. */
+	if (spt->last != NULL && pg_no(spt->last->va) == vpn)
+		return spt->last;
+	if (spt->slots == NULL)
+		return NULL;
+
+	struct page *page = spt_probe(spt, vpn)->page;
+	if (page != NULL)
+		spt->last = page;
+	return page;
 }
 
 
@@ -140,33 +172,93 @@ spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 bool
 spt_insert_page (struct supplemental_page_table *spt UNUSED,
 		struct page *page UNUSED) {
-	int succ = false;
-	
 	/* TODO: Fill this function.
 	* 위의 함수는 인자로 주어진 보조 페이지 테이블에 페이지 구조체를 삽입합니다.
 	* 이 함수에서 주어진 보충 테이블에서 가상 주소가 존재하지 않는지 검사해야 합니다. */
-	if (!hash_insert(&spt->hash_pages, &page->hash_elem))
-		succ = true;
-		
-	return succ;
+
+	/* 사용률을 3/4 아래로 유지해서 탐사 길이를 짧게 둡니다. */
+	if ((spt->page_cnt + 1) * 4 > spt->capacity * 3 && !spt_grow(spt))
+		return false;
+
+	struct spt_slot *slot = spt_probe(spt, pg_no(page->va));
+	if (slot->page != NULL)
+		return false;
+
+	slot->vpn = pg_no(page->va);
+	slot->page = page;
+	spt->page_cnt++;
+	return true;
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
-	hash_delete(&spt->hash_pages, &page->hash_elem);
+	spt_delete(spt, page);
+	if (page->vma != NULL)
+		list_remove(&page->vma_elem);
 	// list_remove(&page->frame->elem);
 	vm_dealloc_page (page);
 }
 
-/* 대체될 구조 프레임을 가져옵니다. */
-/* Get the struct frame, that will be evicted. */
+/* 대체될 구조 프레임을 가져옵니다.
+ * OWNER가 NULL이면 프레임 테이블의 맨 앞 프레임을 고르며, 모두 고정되어 있으면 풀릴 때까지
+ * 기다립니다. 아니면 OWNER의 프레임 중에서 최근에 접근되지 않은 것을 (second chance)
+ * 고릅니다. 고른 프레임은 고정된 채로 반환됩니다. 고를 프레임이 없으면 NULL을 반환합니다. */
+/* Get the struct frame, that will be evicted.
+ * If OWNER is null, takes the first unpinned frame in the frame
+ * table, waiting for the flusher to unpin one if all of them are
+ * pinned.  Otherwise picks one of OWNER's own frames, giving
+ * recently accessed frames a second chance.  The victim comes
+ * back pinned, so that nobody copies or frees its page while it is
+ * being swapped out.  Returns NULL if there is no frame to pick. */
 static struct frame *
-vm_get_victim (void) {
+vm_get_victim (struct thread *owner) {
 	struct frame *victim = NULL;
 	
 	/* TODO: 대체 정책은 여러분의 결정에 달려 있습니다. */
 	/* TODO: The policy for eviction is up to you. */
-	victim = list_entry(list_pop_front(&frame_table), struct frame, elem);
+	lock_acquire(&frame_lock);
+	if (owner == NULL) {
+		/* 플러셔가 쓰고 있는 프레임은 건너뜁니다. 모두 고정되어 있으면 풀릴 때까지 기다립니다. */
+		while (!list_empty(&frame_table)) {
+			for (struct list_elem *e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e)) {
+				struct frame *frame = list_entry(e, struct frame, elem);
+				if (!frame->pinned) {
+					victim = frame;
+					break;
+				}
+			}
+			if (victim != NULL)
+				break;
+			cond_wait(&frames_unpinned, &frame_lock);
+		}
+		if (victim != NULL)
+			list_remove(&victim->elem);
+	} else {
+		struct frame *first = NULL;
+		for (struct list_elem *e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e)) {
+			struct frame *frame = list_entry(e, struct frame, elem);
+			if (frame->thread != owner || frame->pinned)
+				continue;
+			if (first == NULL)
+				first = frame;
+			/* WSS 샘플러가 옮겨 둔 접근 비트도 함께 봅니다. */
+			if (!frame->referenced && !pml4_is_accessed(owner->pml4, frame->page->va)) {
+				victim = frame;
+				break;
+			}
+			frame->referenced = false;
+			pml4_set_accessed(owner->pml4, frame->page->va, false);
+		}
+		if (victim == NULL)
+			victim = first;
+		if (victim != NULL)
+			list_remove(&victim->elem);
+	}
+	if (victim != NULL) {
+		victim->thread->spt.rss--;
+		victim->pinned = true;
+	}
+	lock_release(&frame_lock);
 	return victim;
 }
 
@@ -175,41 +267,64 @@ vm_get_victim (void) {
 /* Evict one page and return the corresponding frame.
  * Return NULL on error.*/
 static struct frame *
-vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
+vm_evict_frame (struct thread *owner) {
+	struct frame *victim UNUSED = vm_get_victim (owner);
+	if (victim == NULL)
+		return NULL;
+	if (owner == NULL)
+		global_evict_cnt++;
+	else
+		local_evict_cnt++;
+	vm_stat_event(VME_EVICT);
 	/* TODO: 희생자를 스왑아웃하고 대체된 프레임을 반환합니다. */
 	/* TODO: swap out the victim and return the evicted frame. */
+	uint64_t start = vm_stat_start();
 	swap_out(victim->page);
+	vm_stat_stop(VMT_SWAP_OUT, start);
+	lock_acquire(&frame_lock);
+	cond_broadcast(&frames_unpinned, &frame_lock);
+	lock_release(&frame_lock);
 	//어차피 victim에 덮어 씌워주면 됨.
 	return victim;
 }
 
 /* palloc()을 호출하고 프레임을 가져옵니다. 사용 가능한 페이지가 없으면 페이지를 대체하고 반환합니다. 
- * 이 함수는 항상 유효한 주소를 반환합니다.  즉, 사용자 풀 메모리가 가득 찬 경우, 이 함수는 사용 가능한 메모리 공간을 얻기 위해 프레임을 대체합니다. */
+ * 사용자 풀 메모리가 가득 찬 경우, 이 함수는 사용 가능한 메모리 공간을 얻기 위해 프레임을 대체합니다.
+ * 내보낼 프레임도 없으면 NULL을 반환합니다. */
 /* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * and return it. That is, if the user pool memory is full, this function
+ * evicts the frame to get the available memory space.  Returns NULL if
+ * there is no frame to evict either.*/
 static struct frame *
 vm_get_frame (void) {
 	struct frame *frame = NULL;
+	struct thread *curr = thread_current();
 	/* TODO: Fill this function. */
-	
-	frame = malloc(sizeof(struct frame));
 
-	// 프레임 구조체 멤버들 초기화
-	frame->kva = palloc_get_page(PAL_USER | PAL_ZERO);
-	if (frame->kva == NULL) {
-		free(frame);
-		frame = vm_evict_frame();
+	/* RSS 제한을 넘었다면 다른 프로세스 대신 자기 페이지를 내보냅니다. */
+	if (curr->spt.rss_limit != 0 && curr->spt.rss >= curr->spt.rss_limit)
+		frame = vm_evict_frame(curr);
+
+	if (frame == NULL) {
+		frame = malloc(sizeof(struct frame));
+
+		// 프레임 구조체 멤버들 초기화
+		if (frame != NULL)
+			frame->kva = palloc_get_page(PAL_USER | PAL_ZERO);
+		if (frame == NULL || frame->kva == NULL) {
+			free(frame);
+			frame = vm_evict_frame(NULL);
+		}
 	}
+	/* 내보낼 프레임도 없으면 호출자가 실패를 처리합니다. */
+	if (frame == NULL)
+		return NULL;
 
 	// list_push_back(&frame_table, &frame->elem);
 
 	frame->page = NULL;
-
-	ASSERT (frame != NULL);
-	ASSERT (frame->page == NULL);
+	frame->pinned = false;
+	frame->referenced = false;
 	return frame;
 }
 
@@ -239,33 +354,58 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 
 	//주소가 존재하지 않을 때 or 커널 가상 주소일 때 (check_address와 똑같음)
 	if (addr == NULL || is_kernel_vaddr(addr)){
+		vm_stat_fault(VMF_BAD);
 		exit(-1);
 		return false;
 	}
 
 	if (not_present){
-		if (USER_STACK - (1 << 20) <= rsp - 8 && rsp - 8 == addr && addr <= USER_STACK) {
-			vm_stack_growth(addr);
-		}
-		else if (USER_STACK - (1 << 20) <= rsp && rsp <= addr && addr <= USER_STACK) {
-			vm_stack_growth(addr);
-		}
-		
+		enum vm_fault_kind kind;
 		page = spt_find_page(spt, addr);
 
-		if (page == NULL){
-			exit(-1);
-			return false;
-		}
+		/* 아직 만들어지지 않은 페이지라면 주소를 덮는 VMA로부터 만듭니다. */
+		if (page == NULL) {
+			struct vma *vma = vma_find(spt, addr);
+			if (vma == NULL) {
+				vm_stat_fault(VMF_BAD);
+				exit(-1);
+				return false;
+			}
+
+			if (vma->kind == VMA_STACK) {
+				/* 스택은 rsp 근처의 접근에 대해서만 자랍니다. */
+				if (rsp - 8 == addr || rsp <= addr)
+					vm_stack_growth(addr);
+				page = spt_find_page(spt, addr);
+				kind = VMF_STACK;
+			} else {
+				page = vma_materialize(spt, vma, addr);
+				kind = VMF_LAZY;
+			}
+
+			if (page == NULL){
+				vm_stat_fault(VMF_BAD);
+				exit(-1);
+				return false;
+			}
+		} else if (VM_TYPE(page->operations->type) == VM_UNINIT)
+			kind = VMF_LAZY;
+		else if (VM_TYPE(page->operations->type) == VM_ANON)
+			kind = VMF_SWAP_IN;
+		else
+			kind = VMF_FILE_IN;
 
 		if (write == true & page->is_writable == false){
+			vm_stat_fault(VMF_BAD);
 			exit(-1);
 			return false;
 		}
 		
+		vm_stat_fault(kind);
 		return vm_do_claim_page (page);
 	}
 
+	vm_stat_fault(VMF_BAD);
 	exit(-1);
 	return false;
 }
@@ -285,8 +425,14 @@ vm_dealloc_page (struct page *page) {
 bool
 vm_claim_page (void *va UNUSED) {
 	struct page *page = NULL;
-	page = spt_find_page(&thread_current()->spt, va);
-	if (page == NULL) return false;
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	page = spt_find_page(spt, va);
+	if (page == NULL) {
+		struct vma *vma = vma_find(spt, va);
+		if (vma == NULL) return false;
+		page = vma_materialize(spt, vma, va);
+		if (page == NULL) return false;
+	}
 	return vm_do_claim_page (page);
 }
 
@@ -294,11 +440,16 @@ vm_claim_page (void *va UNUSED) {
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page (struct page *page) {
+	uint64_t start = vm_stat_start ();
 	struct frame *frame = vm_get_frame ();
 
+	if (frame == NULL)
+		return false;
+
 	/* 링크를 설정합니다. */
 	/* Set links */
 	frame->page = page;
+	frame->thread = thread_current();
 	page->frame = frame;
 
 	/* TODO: 페이지 테이블 항목을 삽입하여 
@@ -310,15 +461,33 @@ vm_do_claim_page (struct page *page) {
 		vm_dealloc_page(page); //@todo: frame table에 있으면 안 해제해주기
 		return false;
 	}
+	lock_acquire(&frame_lock);
 	list_push_back(&frame_table, &frame->elem);
-	return swap_in (page, frame->kva);
+	if (++thread_current()->spt.rss > thread_current()->spt.rss_peak)
+		thread_current()->spt.rss_peak = thread_current()->spt.rss;
+	lock_release(&frame_lock);
+
+	/* 처음 접근하는 uninit 페이지의 초기화와 진짜 swap_in을 따로 잽니다. */
+	enum vm_timer timer = VM_TYPE(page->operations->type) == VM_UNINIT
+		? VMT_UNINIT_INIT : VMT_SWAP_IN;
+	uint64_t swap_start = vm_stat_start();
+	bool success = swap_in (page, frame->kva);
+	vm_stat_stop(timer, swap_start);
+	vm_stat_stop(VMT_CLAIM, start);
+	return success;
 }
 
 /* 새 보조 페이지 테이블을 초기화합니다. */
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
-	hash_init(&spt->hash_pages, page_hash, page_less, NULL);
+	spt->slots = NULL;
+	spt->capacity = spt->page_cnt = 0;
+	spt->last = NULL;
+	vma_init(spt);
+	spt->rss = spt->rss_peak = 0;
+	spt->wss = spt->wss_scan = 0;
+	spt->rss_limit = vm_rss_limit;
 }
 
 
@@ -330,19 +499,19 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 	/* TODO: src의 table을 탐색하면서 table entry를 정확하게 dst 테이블에 만들기 
 	 * TODO: 초기화되지 않은 (uninit) 페이지를 할당하고 그것들을 바로 요청하기 */
 
-	// src table 탐색하기(해시 테이블 탐색)
-	// @todo: hash_apply, 복사 기능 함수
-	// 먼저 hash iterator 사용해서 복사 제대로 되는지 동작 확인하고 복사하는 부분 apply에 넣을 액션 함수로 빼기
-	
 	struct page *src_page;
 	struct page *dst_page;
 
-	struct hash_iterator i;
-	hash_first (&i, &src->hash_pages);
-	while (hash_next (&i)) {
-		src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
-		
-		if (src_page==NULL) return false;
+	/* VMA를 먼저 복사합니다. 아직 초기화되지 않은 페이지와 파일 페이지는
+	 * 자식이 자신의 VMA로부터 다시 만들기 때문에 복사하지 않습니다.
+	 * 자식은 파일을 다시 읽으므로, 부모의 더러운 파일 페이지를 먼저 되돌려 씁니다. */
+	do_msync_all(src);
+	if (!vma_copy(dst, src)) return false;
+
+	for (size_t i = 0; i < src->capacity; i++) {
+		src_page = src->slots[i].page;
+		if (src_page == NULL) continue;
+
 		//src_page->Operations가 anon or unint
 		enum vm_type type = src_page->operations->type;
 		void *va = src_page->va;
@@ -350,21 +519,14 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		// page type 검사
 		switch (type){
 			case VM_UNINIT:
-				//aux 메모리 할당
-				void *aux = malloc(sizeof(struct aux));
-				//parent aux 복사
-				memcpy(aux, src_page->uninit.aux, sizeof(struct aux));
-				//page 할당 후 끝
-				if (!vm_alloc_page_with_initializer(src_page->uninit.type, va, src_page->is_writable, 
-				src_page->uninit.init, aux)) return false;
 				break;
 			case VM_ANON:
 				//페이지만 할당
 				if (!vm_alloc_page(type, va, src_page->is_writable)) return false;
-				//Frame 복사
+				//Frame 복사, 부모 페이지가 스왑 아웃되어 있으면 스왑 슬롯에서 읽음
 				if (dst_page = spt_find_page(dst, va)){
 					if (!vm_do_claim_page(dst_page)) return false;
-					memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+					if (!anon_copy_contents(src_page, dst_page->frame->kva)) return false;
 				}
 				break;
 			default:
@@ -382,40 +544,182 @@ supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
 	
-	hash_clear(&spt->hash_pages, page_destructor);
+	for (size_t i = 0; i < spt->capacity; i++)
+		if (spt->slots[i].page != NULL)
+			vm_dealloc_page(spt->slots[i].page);
+
+	/* exec는 같은 테이블을 다시 쓰므로 빈 상태로 되돌려 둡니다. */
+	free(spt->slots);
+	spt->slots = NULL;
+	spt->capacity = spt->page_cnt = 0;
+	spt->last = NULL;
+	vma_kill(spt);
 }
 
-/* hash table 함수 */
+/* 보조 페이지 테이블 함수 */
 
-/* Returns a hash value for page p. */
-unsigned
-page_hash (const struct hash_elem *p_, void *aux UNUSED) {
-  const struct page *p = hash_entry (p_, struct page, hash_elem);
-  return hash_bytes (&p->va, sizeof p->va);
+/* 페이지 번호 VPN의 홈 슬롯을 반환합니다. 피보나치 해싱으로 이웃한 페이지들을 흩어 놓습니다. */
+/* Returns the home slot of page number VPN.  Fibonacci hashing
+ * spreads neighbouring pages across the table. */
+static inline size_t
+spt_home (const struct supplemental_page_table *spt, uintptr_t vpn) {
+	return ((vpn * 0x9e3779b97f4a7c15ULL) >> 32) & (spt->capacity - 1);
 }
 
-/* Returns true if page a precedes page b. */
-bool
-page_less (const struct hash_elem *a_,
-           const struct hash_elem *b_, void *aux UNUSED) {
-  const struct page *a = hash_entry (a_, struct page, hash_elem);
-  const struct page *b = hash_entry (b_, struct page, hash_elem);
+/* VPN이 들어 있는 슬롯을, 없으면 VPN이 들어갈 빈 슬롯을 반환합니다.
+ * 테이블이 비어 있으면 안 됩니다. */
+/* Returns the slot holding VPN, or the empty slot where VPN
+ * belongs if it is not in SPT.  SPT must have slots. */
+static struct spt_slot *
+spt_probe (struct supplemental_page_table *spt, uintptr_t vpn) {
+	size_t mask = spt->capacity - 1;
+	size_t i = spt_home(spt, vpn);
+
+	while (spt->slots[i].page != NULL && spt->slots[i].vpn != vpn)
+		i = (i + 1) & mask;
+	return &spt->slots[i];
+}
+
+/* 테이블 크기를 두 배로 늘립니다. 메모리가 부족하면 false를 반환합니다. */
+/* Doubles the number of slots in SPT.  Returns false if memory
+ * allocation fails, leaving SPT unchanged. */
+static bool
+spt_grow (struct supplemental_page_table *spt) {
+	struct spt_slot *old_slots = spt->slots;
+	size_t old_capacity = spt->capacity;
+	size_t capacity = old_capacity != 0 ? old_capacity * 2 : SPT_MIN_CAPACITY;
+	struct spt_slot *slots = calloc(capacity, sizeof *slots);
+
+	if (slots == NULL)
+		return false;
 
-  return a->va < b->va;
+	spt->slots = slots;
+	spt->capacity = capacity;
+	for (size_t i = 0; i < old_capacity; i++)
+		if (old_slots[i].page != NULL)
+			*spt_probe(spt, old_slots[i].vpn) = old_slots[i];
+	free(old_slots);
+	return true;
 }
 
+/* PAGE를 테이블에서 뺍니다. 묘비를 남기지 않고 뒤따르는 항목들을 앞으로 당겨서
+ * 탐사 경로가 끊기지 않게 합니다. */
+/* Removes PAGE, which must be in SPT.  Instead of leaving a
+ * tombstone, later entries of the same probe run are shifted back
+ * into the hole so that lookups never have to skip deleted slots. */
+static void
+spt_delete (struct supplemental_page_table *spt, struct page *page) {
+	size_t mask = spt->capacity - 1;
+	size_t hole = spt_probe(spt, pg_no(page->va)) - spt->slots;
+	size_t j = hole;
+
+	ASSERT (spt->slots[hole].page == page);
+
+	for (;;) {
+		j = (j + 1) & mask;
+		if (spt->slots[j].page == NULL)
+			break;
+
+		/* 홈 슬롯이 (hole, j] 안에 있는 항목은 구멍으로 옮기면 찾을 수 없게 됩니다. */
+		/* An entry whose home lies cyclically in (HOLE, J] would
+		 * become unreachable if moved into the hole. */
+		size_t home = spt_home(spt, spt->slots[j].vpn);
+		bool stays = hole <= j ? hole < home && home <= j
+			: hole < home || home <= j;
+		if (!stays) {
+			spt->slots[hole] = spt->slots[j];
+			hole = j;
+		}
+	}
+	spt->slots[hole].page = NULL;
+	spt->page_cnt--;
+
+	if (spt->last == page)
+		spt->last = NULL;
+}
+/* 주기적으로 프레임들의 접근 비트를 읽고 지워서 각 프로세스의 작업 집합 크기를 추정합니다.
+ * 지운 비트는 frame->referenced에 옮겨 두어 교체의 second chance가 그대로 동작합니다. */
+/* Periodically reads and clears the accessed bits of all frames
+ * to estimate the working set size of each process.  A cleared
+ * bit is carried over to frame->referenced, which eviction checks
+ * along with the hardware bit, so sampling does not take away a
+ * page's second chance. */
+static void
+vm_wss_sampler (void *aux UNUSED) {
+	for (;;) {
+		struct list_elem *e;
+
+		timer_sleep (WSS_INTERVAL);
+
+		lock_acquire (&frame_lock);
+		for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e))
+			list_entry (e, struct frame, elem)->thread->spt.wss_scan = 0;
+
+		for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+			struct frame *frame = list_entry (e, struct frame, elem);
+			uint64_t *pml4 = frame->thread->pml4;
+			if (pml4_is_accessed (pml4, frame->page->va)) {
+				frame->thread->spt.wss_scan++;
+				frame->referenced = true;
+				pml4_set_accessed (pml4, frame->page->va, false);
+			}
+		}
+
+		for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+			struct thread *t = list_entry (e, struct frame, elem)->thread;
+			t->spt.wss = t->spt.wss_scan;
+		}
+		lock_release (&frame_lock);
+	}
+}
+
+/* 프레임 테이블 통계와 현재 프로세스의 상주 집합 통계를 STATS에 채웁니다. */
+/* Fills in the frame table statistics of STATS, along with the
+ * resident set statistics of the current process. */
 void
-page_destructor (struct hash_elem *page_elem, void *aux UNUSED){
+vm_rss_get (struct vm_stats *stats) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+
+	lock_acquire (&frame_lock);
+	stats->frames = list_size (&frame_table);
+	stats->global_evictions = global_evict_cnt;
+	stats->local_evictions = local_evict_cnt;
+	stats->rss = spt->rss;
+	stats->rss_peak = spt->rss_peak;
+	stats->rss_limit = spt->rss_limit;
+	stats->wss = spt->wss;
+	lock_release (&frame_lock);
+}
+
+/* 프레임과 프로세스별 상주 집합 통계, 그리고 폴트 통계를 출력합니다.
+ * 패닉 중에도 불릴 수 있으므로 락 대신 인터럽트를 끄고 읽습니다. */
+/* Prints frame and per-process resident set statistics, followed
+ * by the fault and paging statistics.  May be called while
+ * panicking, so interrupts are disabled instead of taking
+ * frame_lock. */
+void
+vm_print_stats (void) {
+	struct list_elem *e;
+	enum intr_level old_level = intr_disable ();
+
+	printf ("Frames: %zu resident, %zu global evictions, %zu local evictions\n",
+			list_size (&frame_table), global_evict_cnt, local_evict_cnt);
 
-	if (page_elem == NULL) return;
+	/* 프레임 테이블에서 각 프로세스를 처음 만날 때 한 번씩만 출력합니다. */
+	for (e = list_begin (&frame_table); e != list_end (&frame_table); e = list_next (e)) {
+		struct thread *t = list_entry (e, struct frame, elem)->thread;
+		struct list_elem *prev;
 
-	struct page *p = hash_entry(page_elem, struct page, hash_elem);
+		for (prev = list_begin (&frame_table); prev != e; prev = list_next (prev))
+			if (list_entry (prev, struct frame, elem)->thread == t)
+				break;
+		if (prev != e)
+			continue;
 
-	if (p == NULL) {
-		// printf("wtf\n");
-		return;
+		printf ("  %s: rss %zu (peak %zu, limit %zu), wss %zu\n", t->name,
+				t->spt.rss, t->spt.rss_peak, t->spt.rss_limit, t->spt.wss);
 	}
+	intr_set_level (old_level);
 
-	//@todo: 동적으로 할당받은게 뭐가 있는지 조사 후 추가
-	vm_dealloc_page(p);
-}
\ No newline at end of file
+	vm_stat_print ();
+}
@@ -0,0 +1,236 @@
+/* vma.c: 가상 메모리 영역(VMA)의 구현.
+ * 각 프로세스는 겹치지 않는 VMA들을 시작 주소 순으로 레드-블랙 트리에 보관합니다.
+ * mmap/munmap은 영역 하나만 트리에 넣고 빼므로 길이와 관계없이 O(log n)이며,
+ * 페이지는 처음 폴트가 날 때 해당 VMA로부터 만들어집니다. */
+/* vma.c: Implementation of virtual memory areas.
+ *
+ * Each process keeps its non-overlapping VMAs in a red-black tree
+ * ordered by start address.  mmap and munmap insert or remove a
+ * single area, so they cost O(log n) regardless of the length of
+ * the mapping.  Pages are materialized from their VMA on the first
+ * fault. */
+
+#include "vm/vma.h"
+#include "vm/vm.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "userprog/process.h"
+
+static bool vma_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED);
+
+/* SPT의 VMA 트리를 초기화합니다. */
+/* Initializes the VMA tree of SPT. */
+void
+vma_init (struct supplemental_page_table *spt) {
+	rb_init (&spt->vmas, vma_less, NULL);
+}
+
+/* [START, END) 범위의 VMA를 만들어 SPT에 넣습니다.
+ * 다른 VMA와 겹치거나 메모리가 부족하면 NULL을 반환합니다.
+ * VMA_FILE 영역은 FILE의 소유권을 가지며, 영역이 사라질 때 FILE을 닫습니다. */
+/* Creates a VMA covering [START, END) and inserts it into SPT.
+ * Returns NULL if the range overlaps an existing VMA or if memory
+ * allocation fails.  A VMA_FILE area takes ownership of FILE and
+ * closes it when the area is destroyed. */
+struct vma *
+vma_create (struct supplemental_page_table *spt, enum vma_kind kind,
+		void *start, void *end, bool writable,
+		struct file *file, off_t ofs, size_t read_bytes) {
+	ASSERT (pg_ofs (start) == 0);
+	ASSERT (pg_ofs (end) == 0);
+	ASSERT (start < end);
+
+	if (vma_overlaps (spt, start, end))
+		return NULL;
+
+	struct vma *vma = malloc (sizeof *vma);
+	if (vma == NULL)
+		return NULL;
+
+	vma->start = start;
+	vma->end = end;
+	vma->kind = kind;
+	vma->writable = writable;
+	vma->file = file;
+	vma->ofs = ofs;
+	vma->read_bytes = read_bytes;
+	list_init (&vma->pages);
+
+	rb_insert (&spt->vmas, &vma->elem);
+	return vma;
+}
+
+/* VA를 포함하는 VMA를 반환합니다. 없으면 NULL을 반환합니다. */
+/* Returns the VMA that contains VA, or NULL if there is none. */
+struct vma *
+vma_find (struct supplemental_page_table *spt, const void *va) {
+	struct vma probe = { .start = pg_round_down (va) };
+	struct rb_elem *e;
+
+	e = rb_floor (&spt->vmas, &probe.elem);
+	if (e == NULL)
+		return NULL;
+
+	struct vma *vma = rb_entry (e, struct vma, elem);
+	return va < vma->end ? vma : NULL;
+}
+
+/* [START, END)와 겹치는 VMA가 있으면 true를 반환합니다.
+ * VMA끼리는 겹치지 않으므로 END보다 앞에서 시작하는 마지막 VMA만 보면 됩니다. */
+/* Returns true if any VMA overlaps [START, END).
+ * Since VMAs never overlap each other, only the last VMA that
+ * starts before END needs to be checked. */
+bool
+vma_overlaps (struct supplemental_page_table *spt,
+		const void *start, const void *end) {
+	struct vma probe = { .start = (uint8_t *) end - 1 };
+	struct rb_elem *e;
+
+	e = rb_floor (&spt->vmas, &probe.elem);
+	return e != NULL && rb_entry (e, struct vma, elem)->end > start;
+}
+
+/* [START, END)와 겹치는 VMA 중 가장 앞의 것을 반환합니다. 없으면 NULL을 반환합니다. */
+/* Returns the lowest VMA that overlaps [START, END), or NULL if
+ * there is none. */
+struct vma *
+vma_first_in (struct supplemental_page_table *spt,
+		const void *start, const void *end) {
+	struct vma *vma = vma_find (spt, start);
+	if (vma != NULL)
+		return vma;
+
+	struct vma probe = { .start = pg_round_down (start) };
+	struct rb_elem *e = rb_ceil (&spt->vmas, &probe.elem);
+	if (e == NULL)
+		return NULL;
+
+	vma = rb_entry (e, struct vma, elem);
+	return vma->start < end ? vma : NULL;
+}
+
+/* 주소 순으로 VMA 다음에 오는 VMA를 반환합니다. */
+/* Returns the VMA that follows VMA in address order, or NULL. */
+struct vma *
+vma_next (struct vma *vma) {
+	struct rb_elem *e = rb_next (&vma->elem);
+	return e != NULL ? rb_entry (e, struct vma, elem) : NULL;
+}
+
+/* VMA 안에 있는 VA의 페이지를 만들어 SPT에 넣고 반환합니다.
+ * 프레임은 할당하지 않습니다. 실패하면 NULL을 반환합니다. */
+/* Creates the page for VA inside VMA, inserts it into SPT and
+ * returns it.  No frame is allocated.  Returns NULL on failure. */
+struct page *
+vma_materialize (struct supplemental_page_table *spt, struct vma *vma,
+		void *va) {
+	void *upage = pg_round_down (va);
+
+	ASSERT (vma->start <= upage && upage < vma->end);
+
+	if (vma->kind == VMA_STACK) {
+		if (!vm_alloc_page (VM_ANON | VM_MARKER_0, upage, true))
+			return NULL;
+		return spt_find_page (spt, upage);
+	}
+
+	size_t page_idx = (uint8_t *) upage - (uint8_t *) vma->start;
+	size_t page_read_bytes = 0;
+	if (page_idx < vma->read_bytes)
+		page_read_bytes = vma->read_bytes - page_idx < PGSIZE
+			? vma->read_bytes - page_idx : PGSIZE;
+
+	struct aux *aux = malloc (sizeof (struct aux));
+	if (aux == NULL)
+		return NULL;
+	aux->file = vma->file;
+	aux->ofs = vma->ofs + page_idx;
+	aux->read_bytes = page_read_bytes;
+	aux->zero_bytes = PGSIZE - page_read_bytes;
+
+	enum vm_type type = vma->kind == VMA_FILE ? VM_FILE : VM_ANON;
+	if (!vm_alloc_page_with_initializer (type, upage, vma->writable,
+				lazy_load_segment, aux))
+		return NULL;
+	return spt_find_page (spt, upage);
+}
+
+/* VMA와 그 안에서 만들어진 페이지들을 모두 제거합니다.
+ * 파일 페이지는 파괴되면서 변경 내용을 파일에 되돌려 씁니다. */
+/* Removes VMA and every page materialized inside it.  File
+ * backed pages write their changes back as they are destroyed. */
+void
+vma_destroy (struct supplemental_page_table *spt, struct vma *vma) {
+	while (!list_empty (&vma->pages)) {
+		struct page *page = list_entry (list_front (&vma->pages),
+				struct page, vma_elem);
+		spt_remove_page (spt, page);
+	}
+
+	rb_delete (&spt->vmas, &vma->elem);
+	if (vma->kind == VMA_FILE)
+		file_close (vma->file);
+	free (vma);
+}
+
+/* SRC의 VMA들을 DST로 복사합니다. 페이지는 복사하지 않습니다.
+ * 파일 매핑은 파일을 다시 열고, 세그먼트는 현재 스레드의 실행 파일을 사용합니다. */
+/* Copies the VMAs of SRC into DST, without any of their pages.
+ * File mappings reopen their file; segments use the executable
+ * of the current thread. */
+bool
+vma_copy (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src) {
+	struct rb_elem *e;
+
+	for (e = rb_first (&src->vmas); e != NULL; e = rb_next (e)) {
+		struct vma *vma = rb_entry (e, struct vma, elem);
+		struct file *file = vma->file;
+
+		if (vma->kind == VMA_FILE) {
+			file = file_reopen (vma->file);
+			if (file == NULL)
+				return false;
+		} else if (vma->kind == VMA_SEGMENT)
+			file = thread_current ()->running;
+
+		if (vma_create (dst, vma->kind, vma->start, vma->end, vma->writable,
+					file, vma->ofs, vma->read_bytes) == NULL) {
+			if (vma->kind == VMA_FILE)
+				file_close (file);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* SPT의 모든 VMA를 해제합니다.
+ * 페이지들은 이미 supplemental_page_table_kill에서 파괴된 상태여야 합니다. */
+/* Frees every VMA of SPT.  The pages must already have been
+ * destroyed by supplemental_page_table_kill. */
+void
+vma_kill (struct supplemental_page_table *spt) {
+	struct rb_elem *e;
+
+	while ((e = rb_first (&spt->vmas)) != NULL) {
+		struct vma *vma = rb_entry (e, struct vma, elem);
+		rb_delete (&spt->vmas, e);
+		if (vma->kind == VMA_FILE)
+			file_close (vma->file);
+		free (vma);
+	}
+}
+
+/* VMA를 시작 주소 순으로 정렬합니다. */
+/* Orders VMAs by start address. */
+static bool
+vma_less (const struct rb_elem *a_, const struct rb_elem *b_,
+		void *aux UNUSED) {
+	const struct vma *a = rb_entry (a_, struct vma, elem);
+	const struct vma *b = rb_entry (b_, struct vma, elem);
+
+	return a->start < b->start;
+}